@@ -0,0 +1,397 @@
+#include <benchmark/benchmark.h>
+#include <json_file.h>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+
+using namespace json;
+
+// Counts every heap allocation made by the benchmark binary so that the corpus benchmarks can
+// report allocations per document next to their throughput
+namespace {
+    std::atomic<std::int64_t> allocation_count{ 0 };
+}
+
+// GCC flags std::free inside a replaced operator delete as a new/free mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+// std::pmr::new_delete_resource allocates through the aligned forms
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align{ static_cast<std::size_t>(alignment) };
+    std::size_t rounded{ (size + align - 1) / align * align };
+#if defined(_MSC_VER)
+    void* ptr{ _aligned_malloc(rounded == 0 ? align : rounded, align) };
+#else
+    void* ptr{ std::aligned_alloc(align, rounded == 0 ? align : rounded) };
+#endif
+    if (ptr) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(ptr, alignment);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+    // Fixed-seed generator so that every run measures the same documents
+    class corpus_random {
+    public:
+
+        explicit corpus_random(std::uint64_t seed) :
+            state_(seed)
+        {
+        }
+
+        std::uint64_t next() {
+            state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+            return state_ >> 33;
+        }
+
+        int next_int(int bound) {
+            return static_cast<int>(next() % static_cast<std::uint64_t>(bound));
+        }
+
+        double next_double(double min, double max) {
+            return min + (max - min) * static_cast<double>(next() % 1000000007ull) / 1000000007.0;
+        }
+
+    private:
+
+        std::uint64_t state_;
+    };
+
+    std::string random_word(corpus_random& random, int min_length, int max_length) {
+        std::string word;
+        int length{ min_length + random.next_int(max_length - min_length + 1) };
+        for (int i = 0; i < length; ++i) {
+            word += static_cast<char>('a' + random.next_int(26));
+        }
+        return word;
+    }
+
+    std::string random_text(corpus_random& random, int words) {
+        std::string text;
+        for (int i = 0; i < words; ++i) {
+            if (i != 0) {
+                text += ' ';
+            }
+            text += random_word(random, 2, 9);
+        }
+        return text;
+    }
+
+    std::string format_double(double value) {
+        char buffer[32];
+        auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return std::string(buffer, ptr);
+    }
+
+    // twitter.json-style: search results of statuses with nested user objects, 64-bit ids,
+    // long texts with escapes and non-ASCII characters, and many null and boolean members
+    std::string twitter_document() {
+        corpus_random random{ 1 };
+        std::string text{ "{\"statuses\":[" };
+        for (int i = 0; i < 100; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            std::string id{ std::to_string(505874924095815681ll + random.next_int(1000000)) };
+            text += "{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"}";
+            text += ",\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\"";
+            text += ",\"id\":" + id + ",\"id_str\":\"" + id + "\"";
+            text += ",\"text\":\"@" + random_word(random, 4, 12) + " " + random_text(random, 12) +
+                " \\u3088\\u308d\\u3057\\u304f \xE3\x81\x8A\xE9\xA1\x98\xE3\x81\x84\\n#" + random_word(random, 3, 8) + "\"";
+            text += ",\"source\":\"<a href=\\\"https://example.com/app\\\" rel=\\\"nofollow\\\">app</a>\"";
+            text += ",\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":null";
+            text += ",\"user\":{\"id\":" + std::to_string(1186275104 + random.next_int(100000)) +
+                ",\"name\":\"" + random_word(random, 3, 10) + "\",\"screen_name\":\"" + random_word(random, 5, 12) +
+                "\",\"location\":\"\",\"description\":\"" + random_text(random, 20) +
+                "\",\"url\":null,\"entities\":{\"description\":{\"urls\":[]}},\"protected\":false" +
+                ",\"followers_count\":" + std::to_string(random.next_int(100000)) +
+                ",\"friends_count\":" + std::to_string(random.next_int(5000)) +
+                ",\"listed_count\":" + std::to_string(random.next_int(100)) +
+                ",\"utc_offset\":null,\"time_zone\":null,\"geo_enabled\":false,\"verified\":false" +
+                ",\"profile_background_color\":\"C0DEED\",\"profile_use_background_image\":true" +
+                ",\"default_profile\":true,\"following\":false,\"notifications\":false}";
+            text += ",\"geo\":null,\"coordinates\":null,\"place\":null,\"contributors\":null";
+            text += ",\"retweet_count\":" + std::to_string(random.next_int(1000)) +
+                ",\"favorite_count\":" + std::to_string(random.next_int(1000));
+            text += ",\"entities\":{\"hashtags\":[{\"text\":\"" + random_word(random, 3, 8) +
+                "\",\"indices\":[" + std::to_string(random.next_int(70)) + "," + std::to_string(70 + random.next_int(70)) +
+                "]}],\"symbols\":[],\"urls\":[],\"user_mentions\":[]}";
+            text += ",\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}";
+        }
+        text += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"count\":100}}";
+        return text;
+    }
+
+    // canada.json-style: a GeoJSON polygon feature dominated by coordinate pairs of doubles
+    std::string canada_document() {
+        corpus_random random{ 2 };
+        std::string text{ "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\"" };
+        text += ",\"properties\":{\"name\":\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+        for (int ring = 0; ring < 480; ++ring) {
+            if (ring != 0) {
+                text += ',';
+            }
+            text += '[';
+            double longitude{ random.next_double(-141.0, -52.0) };
+            double latitude{ random.next_double(41.0, 83.0) };
+            for (int point = 0; point < 230; ++point) {
+                if (point != 0) {
+                    text += ',';
+                }
+                longitude += random.next_double(-0.01, 0.01);
+                latitude += random.next_double(-0.01, 0.01);
+                text += '[';
+                text += format_double(longitude) + ',' + format_double(latitude) + ']';
+            }
+            text += ']';
+        }
+        text += "]}}]}";
+        return text;
+    }
+
+    // citm_catalog.json-style: lookup tables keyed by numeric ids, repeated small objects
+    // with integer members and arrays, and a large share of null values
+    std::string citm_document() {
+        corpus_random random{ 3 };
+        std::string text{ "{\"areaNames\":{" };
+        for (int i = 0; i < 17; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            text += '"';
+            text += std::to_string(205705993 + i) + "\":\"" + random_text(random, 3) + "\"";
+        }
+        text += "},\"events\":{";
+        for (int i = 0; i < 184; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            std::string id{ std::to_string(138586341 + i) };
+            text += '"';
+            text += id + "\":{\"description\":null,\"id\":" + id +
+                ",\"logo\":\"/images/UE0AAAAACEKo6QAAAAVDSVRN\",\"name\":\"" + random_text(random, 4) +
+                "\",\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null" +
+                ",\"topicIds\":[324846099,107888604]}";
+        }
+        text += "},\"performances\":[";
+        for (int i = 0; i < 243; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            text += "{\"eventId\":" + std::to_string(138586341 + random.next_int(184)) +
+                ",\"id\":" + std::to_string(339887544 + i) + ",\"logo\":null,\"name\":null,\"prices\":[";
+            for (int price = 0; price < 3; ++price) {
+                if (price != 0) {
+                    text += ',';
+                }
+                text += "{\"amount\":" + std::to_string(9000 + 500 * random.next_int(40)) +
+                    ",\"audienceSubCategoryId\":337100890,\"seatCategoryId\":" + std::to_string(338937295 + price) + "}";
+            }
+            text += "],\"seatCategories\":[";
+            for (int category = 0; category < 3; ++category) {
+                if (category != 0) {
+                    text += ',';
+                }
+                text += "{\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},{\"areaId\":205705998,\"blockIds\":[]}]"
+                    ",\"seatCategoryId\":" + std::to_string(338937295 + category) + "}";
+            }
+            text += "],\"seatMapImage\":null,\"start\":" + std::to_string(1372701600000ll + 86400000ll * i) +
+                ",\"venueCode\":\"PLEYEL_PLEYEL\"}";
+        }
+        text += "],\"venueNames\":{\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}";
+        return text;
+    }
+
+    const std::string& corpus(int index) {
+        static const std::string documents[]{ twitter_document(), canada_document(), citm_document() };
+        return documents[index];
+    }
+
+    std::filesystem::path write_corpus_file(int index, const char* name) {
+        std::filesystem::path path{ std::filesystem::temp_directory_path() / name };
+        std::ofstream(path, std::ios::binary) << corpus(index);
+        return path;
+    }
+
+    void set_corpus_counters(benchmark::State& state, std::size_t bytes, std::int64_t allocations) {
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+        state.counters["allocs_per_doc"] = benchmark::Counter(
+            static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    }
+
+    template <int Corpus>
+    void corpus_parse(benchmark::State& state) {
+        const std::string& text = corpus(Corpus);
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            json_parser parser(text);
+            json_value value = parser.parse();
+            benchmark::DoNotOptimize(value);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, text.size(), allocations);
+    }
+
+    template <int Corpus>
+    void corpus_parse_two_stage(benchmark::State& state) {
+        const std::string& text = corpus(Corpus);
+        json_parse_options options;
+        options.two_stage = true;
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            json_parser parser(text, options);
+            json_value value = parser.parse();
+            benchmark::DoNotOptimize(value);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, text.size(), allocations);
+    }
+
+    // Stage 1 alone, into an index that keeps its capacity
+    template <int Corpus>
+    void corpus_structural_index(benchmark::State& state) {
+        const std::string& text = corpus(Corpus);
+        json_structural_index index;
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            index.build(text);
+            benchmark::DoNotOptimize(index.offsets().data());
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, text.size(), allocations);
+        state.counters["structurals"] = static_cast<double>(index.size());
+    }
+
+    template <int Corpus>
+    void corpus_from_string(benchmark::State& state) {
+        const std::string& text = corpus(Corpus);
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            json_document document;
+            document.from_string(text);
+            benchmark::DoNotOptimize(document);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, text.size(), allocations);
+    }
+
+    // The corpus document written once to the temporary directory
+    const std::filesystem::path& corpus_file(int index) {
+        static const std::filesystem::path files[]{
+            write_corpus_file(0, "json_bench_twitter.json"),
+            write_corpus_file(1, "json_bench_canada.json"),
+            write_corpus_file(2, "json_bench_citm_catalog.json")
+        };
+        return files[index];
+    }
+
+    // Reads the file into a std::string first, the way callers did before parse_file
+    template <int Corpus>
+    void corpus_read_file(benchmark::State& state) {
+        const std::filesystem::path& path = corpus_file(Corpus);
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            std::ifstream stream(path, std::ios::binary);
+            std::string text{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+            json_document document;
+            document.from_string(text);
+            benchmark::DoNotOptimize(document);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, corpus(Corpus).size(), allocations);
+    }
+
+    template <int Corpus>
+    void corpus_parse_file(benchmark::State& state) {
+        const std::filesystem::path& path = corpus_file(Corpus);
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            json_document document = parse_file(path);
+            benchmark::DoNotOptimize(document);
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, corpus(Corpus).size(), allocations);
+    }
+
+    template <int Corpus>
+    void corpus_to_string(benchmark::State& state) {
+        const json_document document(std::string_view{ corpus(Corpus) });
+        json_serialize_options options;
+        options.pretty = state.range(0) != 0;
+        std::string buffer;
+        std::int64_t allocations{ -allocation_count.load(std::memory_order_relaxed) };
+        for (auto _ : state) {
+            document.to_string(buffer, options);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        allocations += allocation_count.load(std::memory_order_relaxed);
+        set_corpus_counters(state, buffer.size(), allocations);
+    }
+
+} // namespace
+
+BENCHMARK(corpus_parse<0>)->Name("corpus_parse/twitter");
+BENCHMARK(corpus_parse<1>)->Name("corpus_parse/canada");
+BENCHMARK(corpus_parse<2>)->Name("corpus_parse/citm_catalog");
+BENCHMARK(corpus_parse_two_stage<0>)->Name("corpus_parse_two_stage/twitter");
+BENCHMARK(corpus_parse_two_stage<1>)->Name("corpus_parse_two_stage/canada");
+BENCHMARK(corpus_parse_two_stage<2>)->Name("corpus_parse_two_stage/citm_catalog");
+BENCHMARK(corpus_structural_index<0>)->Name("corpus_structural_index/twitter");
+BENCHMARK(corpus_structural_index<1>)->Name("corpus_structural_index/canada");
+BENCHMARK(corpus_structural_index<2>)->Name("corpus_structural_index/citm_catalog");
+BENCHMARK(corpus_from_string<0>)->Name("corpus_from_string/twitter");
+BENCHMARK(corpus_from_string<1>)->Name("corpus_from_string/canada");
+BENCHMARK(corpus_from_string<2>)->Name("corpus_from_string/citm_catalog");
+BENCHMARK(corpus_read_file<0>)->Name("corpus_read_file/twitter");
+BENCHMARK(corpus_read_file<1>)->Name("corpus_read_file/canada");
+BENCHMARK(corpus_read_file<2>)->Name("corpus_read_file/citm_catalog");
+BENCHMARK(corpus_parse_file<0>)->Name("corpus_parse_file/twitter");
+BENCHMARK(corpus_parse_file<1>)->Name("corpus_parse_file/canada");
+BENCHMARK(corpus_parse_file<2>)->Name("corpus_parse_file/citm_catalog");
+BENCHMARK(corpus_to_string<0>)->Name("corpus_to_string/twitter")->ArgName("pretty")->Arg(0)->Arg(1);
+BENCHMARK(corpus_to_string<1>)->Name("corpus_to_string/canada")->ArgName("pretty")->Arg(0)->Arg(1);
+BENCHMARK(corpus_to_string<2>)->Name("corpus_to_string/citm_catalog")->ArgName("pretty")->Arg(0)->Arg(1);
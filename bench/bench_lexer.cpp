@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    json_value make_record(json_int_t id, int depth) {
+        json_object record{
+            {"id", id},
+            {"name", "record"},
+            {"score", 0.5 * static_cast<double>(id)},
+            {"tags", json_array{"a", "b", "c"}}
+        };
+        if (depth > 0) {
+            record.emplace("child", make_record(id + 1, depth - 1));
+        }
+        return json_value(std::move(record));
+    }
+
+    // Pretty-printed arrays of records; range(0) is the nesting depth of each record,
+    // deeper records mean longer indentation runs between tokens
+    const std::string& pretty_document(int depth) {
+        static std::unordered_map<int, std::string> cache;
+        auto it = cache.find(depth);
+        if (it == cache.end()) {
+            json_array records;
+            for (json_int_t i = 0; i < 2000 / (depth + 1); ++i) {
+                records.push_back(make_record(i, depth));
+            }
+            it = cache.emplace(depth, json_document(json_value(std::move(records))).to_string()).first;
+        }
+        return it->second;
+    }
+
+    template <auto SkipWhitespace>
+    void skip_whitespace(benchmark::State& state) {
+        const std::string& text = pretty_document(static_cast<int>(state.range(0)));
+        const char* last = text.data() + text.size();
+        for (auto _ : state) {
+            const char* pos = text.data();
+            std::size_t tokens = 0;
+            while (pos != last) {
+                if (detail::is_space(*pos)) {
+                    pos = SkipWhitespace(pos, last);
+                }
+                if (pos != last) {
+                    ++pos;
+                    ++tokens;
+                }
+            }
+            benchmark::DoNotOptimize(tokens);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+#if defined(JSON_HAS_SSE2)
+    void skip_whitespace_avx2(benchmark::State& state) {
+        if (!detail::cpu_has_avx2()) {
+            state.SkipWithError("AVX2 is not supported by this CPU");
+            return;
+        }
+        skip_whitespace<&detail::skip_whitespace_avx2>(state);
+    }
+#endif
+
+    void lex_pretty_document(benchmark::State& state) {
+        const std::string& text = pretty_document(static_cast<int>(state.range(0)));
+        for (auto _ : state) {
+            json_lexer lexer(text);
+            std::size_t tokens = 0;
+            while (lexer.next_token().type != json_token_type::end_of_file) {
+                ++tokens;
+            }
+            benchmark::DoNotOptimize(tokens);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    // Array of long log-message-like strings, range(0) is the string length
+    const std::string& string_document(int length) {
+        static std::unordered_map<int, std::string> cache;
+        auto it = cache.find(length);
+        if (it == cache.end()) {
+            std::string message;
+            for (int i = 0; i < length; ++i) {
+                message += static_cast<char>('a' + i % 26);
+            }
+            json_array strings(256, json_value(message));
+            it = cache.emplace(length, json_document(json_value(std::move(strings))).to_string()).first;
+        }
+        return it->second;
+    }
+
+    void lex_long_strings(benchmark::State& state) {
+        const std::string& text = string_document(static_cast<int>(state.range(0)));
+        for (auto _ : state) {
+            json_lexer lexer(text);
+            std::size_t tokens = 0;
+            while (lexer.next_token().type != json_token_type::end_of_file) {
+                ++tokens;
+            }
+            benchmark::DoNotOptimize(tokens);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+} // namespace
+
+BENCHMARK(skip_whitespace<&detail::skip_whitespace_scalar>)->Name("skip_whitespace/scalar")->Arg(0)->Arg(8);
+#if defined(JSON_HAS_SSE2)
+BENCHMARK(skip_whitespace<&detail::skip_whitespace_sse2>)->Name("skip_whitespace/sse2")->Arg(0)->Arg(8);
+BENCHMARK(skip_whitespace_avx2)->Name("skip_whitespace/avx2")->Arg(0)->Arg(8);
+#endif
+BENCHMARK(skip_whitespace<&detail::skip_whitespace>)->Name("skip_whitespace/dispatch")->Arg(0)->Arg(8);
+BENCHMARK(lex_pretty_document)->Arg(0)->Arg(8);
+BENCHMARK(lex_long_strings)->Arg(16)->Arg(256)->Arg(4096);
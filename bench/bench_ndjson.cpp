@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include <json_ndjson.h>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    // About 16 MB of JSON Lines, one small event record per line
+    const std::string& event_lines() {
+        static const std::string text = [] {
+            std::string result;
+            for (int i = 0; i < 100000; ++i) {
+                result += "{\"id\":" + std::to_string(i) + ",\"user\":{\"name\":\"user" + std::to_string(i % 977) +
+                    "\",\"verified\":" + (i % 3 == 0 ? "true" : "false") + "},\"score\":" + std::to_string(i % 100) +
+                    ".25,\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"text\":\"event text with a few words in it\"}\n";
+            }
+            return result;
+        }();
+        return text;
+    }
+
+    // range(0) worker threads
+    void ndjson_parse(benchmark::State& state) {
+        const std::string& text = event_lines();
+        json_ndjson_options options;
+        options.threads = static_cast<std::size_t>(state.range(0));
+        for (auto _ : state) {
+            json_ndjson_reader reader(text, options);
+            std::size_t records{ 0 };
+            reader.for_each([&records](json_ndjson_record&& record) {
+                records += record.document.is_valid();
+            });
+            benchmark::DoNotOptimize(records);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+} // namespace
+
+BENCHMARK(ndjson_parse)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+#include <charconv>
+#include <random>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    // Flat arrays of 10000 numbers, printed compactly
+    std::string number_array(bool doubles) {
+        std::mt19937_64 rng(42);
+        std::string text{ "[" };
+        for (int i = 0; i < 10000; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            if (doubles) {
+                std::uniform_real_distribution<double> dist(-1e6, 1e6);
+                char buffer[32];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), dist(rng));
+                text.append(buffer, result.ptr);
+                if (std::string_view(buffer, result.ptr).find_first_of(".e") == std::string_view::npos) {
+                    text += ".0";
+                }
+            }
+            else {
+                text += std::to_string(static_cast<json_int_t>(rng() >> 8) - (1ll << 54));
+            }
+        }
+        text += ']';
+        return text;
+    }
+
+    const std::string& integers() {
+        static const std::string text{ number_array(false) };
+        return text;
+    }
+
+    const std::string& doubles() {
+        static const std::string text{ number_array(true) };
+        return text;
+    }
+
+    void lex_numbers(benchmark::State& state, const std::string& text) {
+        for (auto _ : state) {
+            json_lexer lexer(text);
+            std::size_t tokens = 0;
+            while (lexer.next_token().type != json_token_type::end_of_file) {
+                ++tokens;
+            }
+            benchmark::DoNotOptimize(tokens);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    void parse_numbers(benchmark::State& state, const std::string& text) {
+        for (auto _ : state) {
+            json_parser parser(text);
+            json_value value = parser.parse();
+            benchmark::DoNotOptimize(value);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+} // namespace
+
+BENCHMARK_CAPTURE(lex_numbers, integers, integers());
+BENCHMARK_CAPTURE(lex_numbers, doubles, doubles());
+BENCHMARK_CAPTURE(parse_numbers, integers, integers());
+BENCHMARK_CAPTURE(parse_numbers, doubles, doubles());
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    // About 2 MB: a large records array between the two members the benchmarks read
+    const std::string& large_document() {
+        static const std::string text = [] {
+            std::string result{ "{\"request_id\":\"a81f\",\"records\":[" };
+            for (int i = 0; i < 20000; ++i) {
+                if (i != 0) {
+                    result += ',';
+                }
+                result += "{\"id\":" + std::to_string(i) + ",\"name\":\"record name\",\"score\":" +
+                    std::to_string(i) + ".5,\"tags\":[\"a\",\"b\",\"c\"],\"nested\":{\"ok\":true,\"next\":null}}";
+            }
+            result += "],\"status\":200}";
+            return result;
+        }();
+        return text;
+    }
+
+    void two_fields_dom(benchmark::State& state) {
+        const std::string& text = large_document();
+        for (auto _ : state) {
+            json_parser parser(text);
+            json_value root = parser.parse();
+            const json_object& object = root.as<json_object>();
+            benchmark::DoNotOptimize(object.at("request_id").as<json_string_t>().size());
+            benchmark::DoNotOptimize(object.at("status").as<json_int_t>());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    void two_fields_ondemand(benchmark::State& state) {
+        const std::string& text = large_document();
+        json_parse_options options;
+        options.two_stage = state.range(0) != 0;
+        std::string scratch;
+        for (auto _ : state) {
+            json_ondemand_document document(text, options);
+            json_ondemand_value root = document.root();
+            benchmark::DoNotOptimize(root["request_id"].get_string(scratch).size());
+            benchmark::DoNotOptimize(root["status"].get_int());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+} // namespace
+
+BENCHMARK(two_fields_dom);
+BENCHMARK(two_fields_ondemand)->ArgName("two_stage")->Arg(0)->Arg(1);
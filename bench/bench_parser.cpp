@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+#include <memory_resource>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    // range(0) levels of {"level": n, "items": [1, 2, {...}]}
+    std::string nested_document(int depth) {
+        std::string text;
+        for (int i = 0; i < depth; ++i) {
+            text += "{\"level\":" + std::to_string(i) + ",\"items\":[1,2,";
+        }
+        text += "null";
+        for (int i = 0; i < depth; ++i) {
+            text += "]}";
+        }
+        return text;
+    }
+
+    // Array of range(0) small objects
+    std::string wide_document(int count) {
+        std::string text{ "[" };
+        for (int i = 0; i < count; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            text += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\",\"tags\":[\"a\",\"b\"],\"ok\":true}";
+        }
+        text += ']';
+        return text;
+    }
+
+    // Array of range(0) records whose member names do not fit inline in a json_key
+    std::string long_key_document(int count) {
+        std::string text{ "[" };
+        for (int i = 0; i < count; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            text += "{\"customer_identifier\":" + std::to_string(i) +
+                ",\"shipping_address_line\":\"street\",\"preferred_contact_method\":\"mail\"" +
+                ",\"is_subscribed_to_newsletter\":false}";
+        }
+        text += ']';
+        return text;
+    }
+
+    void parse_document(benchmark::State& state, const std::string& text, json_key_table* key_table = nullptr) {
+        json_parse_options options;
+        options.max_depth = 1024;
+        options.key_table = key_table;
+        for (auto _ : state) {
+            json_parser parser(text, options);
+            json_value value = parser.parse();
+            benchmark::DoNotOptimize(value);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    // Same as parse_document, every node comes from one arena released after each document
+    void parse_document_arena(benchmark::State& state, const std::string& text) {
+        std::pmr::monotonic_buffer_resource arena;
+        json_parse_options options;
+        options.max_depth = 1024;
+        options.memory_resource = &arena;
+        for (auto _ : state) {
+            {
+                json_parser parser(text, options);
+                json_value value = parser.parse();
+                benchmark::DoNotOptimize(value);
+            }
+            arena.release();
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    void parse_nested(benchmark::State& state) {
+        static const std::string text{ nested_document(500) };
+        parse_document(state, text);
+    }
+
+    void parse_wide(benchmark::State& state) {
+        static const std::string text{ wide_document(10000) };
+        parse_document(state, text);
+    }
+
+    void parse_nested_arena(benchmark::State& state) {
+        static const std::string text{ nested_document(500) };
+        parse_document_arena(state, text);
+    }
+
+    void parse_wide_arena(benchmark::State& state) {
+        static const std::string text{ wide_document(10000) };
+        parse_document_arena(state, text);
+    }
+
+    void parse_long_keys(benchmark::State& state) {
+        static const std::string text{ long_key_document(10000) };
+        parse_document(state, text);
+    }
+
+    void parse_long_keys_interned(benchmark::State& state) {
+        static const std::string text{ long_key_document(10000) };
+        json_key_table key_table;
+        parse_document(state, text, &key_table);
+    }
+
+    // The wide document fed to json_push_parser in range(0)-byte chunks
+    void parse_push(benchmark::State& state) {
+        static const std::string text{ wide_document(10000) };
+        std::size_t chunk{ static_cast<std::size_t>(state.range(0)) };
+        for (auto _ : state) {
+            json_push_parser parser;
+            for (std::size_t pos = 0; pos < text.size(); pos += chunk) {
+                parser.feed(std::string_view(text).substr(pos, chunk));
+            }
+            json_value value = parser.finish();
+            benchmark::DoNotOptimize(value);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    // One string of range(0) bytes arriving in 4 KB chunks, pending across all of them
+    void parse_push_long_string(benchmark::State& state) {
+        std::string text{ "[\"" + std::string(static_cast<std::size_t>(state.range(0)), 'x') + "\"]" };
+        for (auto _ : state) {
+            json_push_parser parser;
+            for (std::size_t pos = 0; pos < text.size(); pos += 4096) {
+                parser.feed(std::string_view(text).substr(pos, 4096));
+            }
+            json_value value = parser.finish();
+            benchmark::DoNotOptimize(value);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    // The records of the wide document written back to back without separators, read one value at a time
+    void parse_stream(benchmark::State& state) {
+        static const std::string text = [] {
+            std::string result;
+            for (int i = 0; i < 10000; ++i) {
+                result += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\",\"tags\":[\"a\",\"b\"],\"ok\":true}";
+            }
+            return result;
+        }();
+        for (auto _ : state) {
+            json_parser parser(text);
+            json_value value;
+            std::size_t count{ 0 };
+            while (parser.parse_next(value)) {
+                ++count;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+    // Sums every "id" member through the handler interface, no tree is built
+    struct id_sum_handler : json_null_handler {
+        bool on_key(std::string_view key) {
+            is_id = key == "id";
+            return true;
+        }
+        bool on_int(json_int_t value) {
+            if (is_id) {
+                sum += value;
+            }
+            return true;
+        }
+        bool is_id{ false };
+        json_int_t sum{ 0 };
+    };
+
+    void parse_wide_handler(benchmark::State& state) {
+        static const std::string text{ wide_document(10000) };
+        for (auto _ : state) {
+            json_parser parser(text);
+            id_sum_handler handler;
+            parser.parse(handler);
+            benchmark::DoNotOptimize(handler.sum);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+    }
+
+} // namespace
+
+BENCHMARK(parse_nested);
+BENCHMARK(parse_wide);
+BENCHMARK(parse_nested_arena);
+BENCHMARK(parse_wide_arena);
+BENCHMARK(parse_long_keys);
+BENCHMARK(parse_long_keys_interned);
+BENCHMARK(parse_wide_handler);
+BENCHMARK(parse_stream);
+BENCHMARK(parse_push)->Arg(64)->Arg(4096)->Arg(65536);
+BENCHMARK(parse_push_long_string)->Arg(1 << 20);
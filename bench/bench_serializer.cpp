@@ -0,0 +1,165 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+#include <string>
+
+using namespace json;
+
+namespace {
+
+    // Array of range(0) small records mixing every scalar type
+    json_document record_document(int count) {
+        std::string text{ "[" };
+        for (int i = 0; i < count; ++i) {
+            if (i != 0) {
+                text += ',';
+            }
+            text += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\\n" + std::to_string(i) +
+                "\",\"price\":" + std::to_string(i) + ".25,\"tags\":[\"a\",\"b\"],\"ok\":true,\"next\":null}";
+        }
+        text += ']';
+        json_document document;
+        document.from_string(text);
+        return document;
+    }
+
+    // range(0) numbers spread over several orders of magnitude
+    json_document number_document(int count, bool integral) {
+        json_array array;
+        array.reserve(static_cast<std::size_t>(count));
+        double value{ 0.1 };
+        for (int i = 0; i < count; ++i) {
+            value = value * 1.37 + 0.013;
+            if (value > 1e12) {
+                value = 0.1;
+            }
+            if (integral) {
+                array.emplace_back(static_cast<json_int_t>(value) * (i % 2 == 0 ? 1 : -1));
+            }
+            else {
+                array.emplace_back(value * (i % 2 == 0 ? 1 : -1));
+            }
+        }
+        return json_document(json_value(std::move(array)));
+    }
+
+    void serialize_numbers(benchmark::State& state, const json_document& document) {
+        json_serialize_options options;
+        options.pretty = false;
+        std::string buffer;
+        for (auto _ : state) {
+            document.to_string(buffer, options);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * document.root().as<json_array>().size()));
+    }
+
+    void serialize_doubles(benchmark::State& state) {
+        static const json_document document{ number_document(100000, false) };
+        serialize_numbers(state, document);
+    }
+
+    void serialize_integers(benchmark::State& state) {
+        static const json_document document{ number_document(100000, true) };
+        serialize_numbers(state, document);
+    }
+
+    // Array of 1000 log lines of range(0) bytes; every 64th byte is a tab that needs escaping
+    json_document text_document(std::size_t length) {
+        json_array array;
+        for (int i = 0; i < 1000; ++i) {
+            std::string line;
+            line.reserve(length);
+            for (std::size_t j = 0; j < length; ++j) {
+                line += j % 64 == 63 ? '\t' : static_cast<char>('a' + (i + j) % 26);
+            }
+            array.emplace_back(line);
+        }
+        return json_document(json_value(std::move(array)));
+    }
+
+    void serialize_text(benchmark::State& state) {
+        const json_document document{ text_document(static_cast<std::size_t>(state.range(0))) };
+        json_serialize_options options;
+        options.pretty = false;
+        std::string buffer;
+        for (auto _ : state) {
+            document.to_string(buffer, options);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+    }
+
+    const json_document& records() {
+        static const json_document document{ record_document(10000) };
+        return document;
+    }
+
+    void serialize_to_string(benchmark::State& state) {
+        std::size_t bytes{ 0 };
+        for (auto _ : state) {
+            std::string text{ records().to_string() };
+            bytes = text.size();
+            benchmark::DoNotOptimize(text);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+
+    void serialize_reused_buffer(benchmark::State& state) {
+        std::string buffer;
+        for (auto _ : state) {
+            records().to_string(buffer);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+        state.counters["doc_bytes"] = static_cast<double>(buffer.size());
+    }
+
+    void serialize_compact(benchmark::State& state) {
+        json_serialize_options options;
+        options.pretty = false;
+        std::string buffer;
+        for (auto _ : state) {
+            records().to_string(buffer, options);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+        state.counters["doc_bytes"] = static_cast<double>(buffer.size());
+    }
+
+    void serialize_compact_sorted(benchmark::State& state) {
+        json_serialize_options options;
+        options.pretty = false;
+        options.sort_keys = true;
+        std::string buffer;
+        for (auto _ : state) {
+            records().to_string(buffer, options);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * buffer.size()));
+    }
+
+    // Chunks of range(0) bytes handed to a sink that only counts them
+    void serialize_sink(benchmark::State& state) {
+        std::size_t bytes{ 0 };
+        json_writer writer([&](std::string_view chunk) {
+            benchmark::DoNotOptimize(chunk.data());
+            bytes += chunk.size();
+        }, static_cast<std::size_t>(state.range(0)));
+        for (auto _ : state) {
+            records().write(writer);
+            writer.flush();
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+    }
+
+} // namespace
+
+BENCHMARK(serialize_to_string);
+BENCHMARK(serialize_reused_buffer);
+BENCHMARK(serialize_compact);
+BENCHMARK(serialize_compact_sorted);
+BENCHMARK(serialize_doubles);
+BENCHMARK(serialize_integers);
+BENCHMARK(serialize_text)->Arg(16)->Arg(256)->Arg(4096);
+BENCHMARK(serialize_sink)->Arg(4096)->Arg(65536);
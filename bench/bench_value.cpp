@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+#include <json.h>
+
+using namespace json;
+
+namespace {
+
+    json_array int_array(std::size_t count) {
+        json_array array;
+        array.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            array.emplace_back(static_cast<json_int_t>(i));
+        }
+        return array;
+    }
+
+    // Sums range(0) integers held in a json_array
+    void traverse_int_array(benchmark::State& state) {
+        const json_array array(int_array(static_cast<std::size_t>(state.range(0))));
+        for (auto _ : state) {
+            json_int_t sum{ 0 };
+            for (const json_value& value : array) {
+                sum += value.as<json_int_t>();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * array.size()));
+        state.counters["node_bytes"] = sizeof(json_value);
+    }
+
+} // namespace
+
+BENCHMARK(traverse_int_array)->Arg(1 << 10)->Arg(1 << 20);
@@ -0,0 +1,42 @@
+# Header-only json library target: json::json
+#   JSON_INSTALL             generate install rules and the json-config.cmake package
+#   JSON_PRECOMPILED_HEADER  precompile json.h once per consuming target instead of in every TU
+
+option(JSON_INSTALL "Generate install rules for json::json" ON)
+option(JSON_PRECOMPILED_HEADER "Precompile json.h in targets linking json::json" OFF)
+
+include(GNUInstallDirs)
+
+add_library(json INTERFACE)
+add_library(json::json ALIAS json)
+
+target_include_directories(json INTERFACE
+    $<BUILD_INTERFACE:${CMAKE_CURRENT_SOURCE_DIR}/include>
+    $<INSTALL_INTERFACE:${CMAKE_INSTALL_INCLUDEDIR}>)
+target_compile_features(json INTERFACE cxx_std_20)
+
+# Interface precompiled headers are not exported, installed consumers opt in with
+# target_precompile_headers(<target> PRIVATE <json.h>)
+if(JSON_PRECOMPILED_HEADER)
+    target_precompile_headers(json INTERFACE
+        $<BUILD_INTERFACE:${CMAKE_CURRENT_SOURCE_DIR}/include/json.h>)
+endif()
+
+if(JSON_INSTALL)
+    include(CMakePackageConfigHelpers)
+
+    install(TARGETS json EXPORT json-targets)
+    install(FILES ${CMAKE_CURRENT_SOURCE_DIR}/include/json.h ${CMAKE_CURRENT_SOURCE_DIR}/include/json_file.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/include/json_ndjson.h
+        DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
+    install(EXPORT json-targets
+        NAMESPACE json::
+        DESTINATION ${CMAKE_INSTALL_LIBDIR}/cmake/json)
+
+    configure_package_config_file(
+        ${CMAKE_CURRENT_SOURCE_DIR}/cmake/json-config.cmake.in
+        ${CMAKE_CURRENT_BINARY_DIR}/json-config.cmake
+        INSTALL_DESTINATION ${CMAKE_INSTALL_LIBDIR}/cmake/json)
+    install(FILES ${CMAKE_CURRENT_BINARY_DIR}/json-config.cmake
+        DESTINATION ${CMAKE_INSTALL_LIBDIR}/cmake/json)
+endif()
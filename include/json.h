@@ -1,15 +1,47 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <mutex>
 #include <cmath>
+#include <array>
+#include <bit>
+#include <charconv>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
-#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <optional>
+#include <span>
+#include <memory_resource>
+#include <functional>
+#include <concepts>
 #include <stack>
-#include <cassert>
-#include <format>
+
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_HAS_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(JSON_NO_SIMD)
+#undef JSON_HAS_SSE2
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define JSON_TARGET_AVX2
+#endif
 
 namespace json {
 
@@ -19,711 +51,3014 @@ namespace json {
     using json_bool_t = bool;
     using json_int_t = long long;
     using json_double_t = double;
-    using json_string_t = std::string;
-
-    using json_array = std::vector<json_value>;
-    using json_object = std::unordered_map<json_string_t, json_value>;
+    using json_string_t = std::pmr::string;
 
     namespace concepts {
         template <typename T>
-        concept is_int = (std::is_integral_v<T> && !std::is_same_v<T, bool>);
-
-        template <typename T>
-        concept is_json_value =
-            std::is_same_v<T, json_null_t> ||
-            std::is_same_v<T, json_bool_t> ||
-            std::is_same_v<T, json_int_t> ||
-            std::is_same_v<T, json_double_t> ||
-            std::is_same_v<T, json_string_t> ||
-            std::is_same_v<T, json_array> ||
-            std::is_same_v<T, json_object> ||
-            std::is_same_v<T, const char*>;
+        concept is_key_like = std::is_convertible_v<const T&, std::string_view>;
 
     } // namespace concepts
 
-    class json_value {
+    // Object member name in 16 bytes. Names of up to 15 bytes are stored inline and never
+    // allocate; longer names live in an immutable reference-counted entry. Keys obtained from
+    // the same json_key_table share one entry per distinct name and compare by pointer.
+    class json_key {
     public:
 
-        using value_type = std::variant<
-            json_null_t,
-            json_bool_t,
-            json_int_t,
-            json_double_t,
-            json_string_t,
-            json_array,
-            json_object
-        >;
+        static constexpr std::size_t inline_capacity{ 15 };
 
     public:
 
-        json_value() :
-            value_{ nullptr }
-        {
+        json_key() noexcept {
+            std::memset(bytes_, 0, sizeof(bytes_));
         }
 
-        template <typename T>
-            requires (concepts::is_json_value<T> || concepts::is_int<T>)
-        json_value(T value) :
-            value_(std::conditional_t<std::is_integral_v<T>, json_int_t, T>(std::move(value)))
-        {
+        json_key(std::string_view text, std::pmr::memory_resource* resource = nullptr) {
+            std::memset(bytes_, 0, sizeof(bytes_));
+            if (text.size() <= inline_capacity) {
+                std::memcpy(bytes_, text.data(), text.size());
+                bytes_[tag_index_] = static_cast<unsigned char>(text.size());
+            }
+            else {
+                set_entry_(make_entry_(text, std::hash<std::string_view>{}(text), 0,
+                    resource ? resource : std::pmr::get_default_resource()));
+            }
         }
 
-        json_value(json_null_t) :
-            value_(nullptr)
+        json_key(const char* text) :
+            json_key(std::string_view(text))
         {
         }
 
-        explicit json_value(const char* value) :
-            value_(std::string(value))
+        json_key(const std::string& text) :
+            json_key(std::string_view(text))
         {
         }
 
-        explicit json_value(std::initializer_list<json_value> list)
+        json_key(const json_string_t& text) :
+            json_key(std::string_view(text), text.get_allocator().resource())
         {
-            if (list.size() == 1) {
-                json_value tmp(*(list.begin()));
-                std::swap(tmp.value_, value_);
-            }
-            else {
-                json_array tmp;
-                tmp.reserve(list.size());
-                for (const auto& item : list) {
-                    tmp.push_back(item);
+        }
+
+        // Like the values around them, copies take their memory from the default resource: only
+        // interned entries, and entries that already live there, are shared. Any other entry
+        // belongs to a resource (a parser arena, say) that may be released before the copy.
+        json_key(const json_key& other) {
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            if (is_shared_()) {
+                entry_t* entry{ entry_() };
+                std::pmr::memory_resource* resource{ std::pmr::get_default_resource() };
+                if (entry->table != 0 || entry->resource == resource || entry->resource == std::pmr::new_delete_resource()) {
+                    entry->refs.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    set_entry_(make_entry_({ entry->chars(), entry->size }, entry->hash, 0, resource));
                 }
-                value_ = std::move(tmp);
             }
         }
 
-        json_value(const json_value&) = default;
-        json_value(json_value&&) noexcept = default;
-        json_value& operator=(const json_value&) = default;
-        json_value& operator=(json_value&&) noexcept = default;
+        json_key(json_key&& other) noexcept {
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            std::memset(other.bytes_, 0, sizeof(other.bytes_));
+        }
+
+        json_key& operator=(const json_key& other) {
+            json_key tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        json_key& operator=(json_key&& other) noexcept {
+            json_key tmp(std::move(other));
+            swap(tmp);
+            return *this;
+        }
+
+        ~json_key() {
+            if (is_shared_()) {
+                release_(entry_());
+            }
+        }
 
     public:
 
-        template <typename T>
-            requires (concepts::is_json_value<T>)
-        [[nodiscard]] T& as() {
-            return std::get<T>(value_);
+        void swap(json_key& other) noexcept {
+            unsigned char tmp[sizeof(bytes_)];
+            std::memcpy(tmp, bytes_, sizeof(bytes_));
+            std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+            std::memcpy(other.bytes_, tmp, sizeof(bytes_));
         }
 
-        template <typename T>
-            requires (concepts::is_json_value<T>)
-        [[nodiscard]] const T& as() const {
-            return std::get<T>(value_);
+        std::string_view view() const noexcept {
+            if (is_shared_()) {
+                const entry_t* entry{ entry_() };
+                return { entry->chars(), entry->size };
+            }
+            return { reinterpret_cast<const char*>(bytes_), bytes_[tag_index_] };
         }
 
-        template <typename T>
-            requires (concepts::is_json_value<T>)
-        [[nodiscard]] T* try_as() {
-            return is<T>() ? &std::get<T>(value_) : nullptr;
+        operator std::string_view() const noexcept {
+            return view();
         }
 
-        template <typename T>
-            requires (concepts::is_json_value<T>)
-        [[nodiscard]] const T* try_as() const {
-            return is<T>() ? &std::get<T>(value_) : nullptr;
+        std::size_t size() const noexcept {
+            return is_shared_() ? entry_()->size : bytes_[tag_index_];
         }
 
-        template <typename T>
-            requires (concepts::is_json_value<T>)
-        [[nodiscard]] bool is() const {
-            return std::holds_alternative<T>(value_);
+        bool empty() const noexcept {
+            return size() == 0;
+        }
+
+        bool is_inline() const noexcept {
+            return !is_shared_();
+        }
+
+        std::size_t hash() const noexcept {
+            return is_shared_() ? entry_()->hash : std::hash<std::string_view>{}(view());
+        }
+
+        friend bool operator==(const json_key& lhs, const json_key& rhs) noexcept {
+            if (lhs.bytes_[tag_index_] != rhs.bytes_[tag_index_]) {
+                return false;
+            }
+            if (!lhs.is_shared_()) {
+                return std::memcmp(lhs.bytes_, rhs.bytes_, sizeof(bytes_)) == 0;
+            }
+            const entry_t* left{ lhs.entry_() };
+            const entry_t* right{ rhs.entry_() };
+            if (left == right) {
+                return true;
+            }
+            // Interned in the same table: one entry per name, so different entries differ
+            if (left->table != 0 && left->table == right->table) {
+                return false;
+            }
+            return left->hash == right->hash && lhs.view() == rhs.view();
+        }
+
+        template <concepts::is_key_like K>
+            requires (!std::is_same_v<K, json_key>)
+        friend bool operator==(const json_key& lhs, const K& rhs) noexcept {
+            return lhs.view() == std::string_view(rhs);
         }
 
     private:
 
-        value_type value_;
+        friend class json_key_table;
 
-    }; // class json_value
+        struct entry_t {
+            std::atomic<std::uint32_t> refs;
+            std::uint32_t size;
+            std::size_t hash;
+            std::uint64_t table;
+            std::pmr::memory_resource* resource;
 
-    enum class json_token_type : std::uint8_t {
-        invalid,
-        left_bracket, right_bracket,
-        left_brace, right_brace,
-        colon, comma,
-        string_value, int_value, double_value, bool_value, null_value,
-        end_of_file
-    };
+            char* chars() noexcept {
+                return reinterpret_cast<char*>(this + 1);
+            }
 
-    constexpr bool is_value_token(json_token_type type) {
-        return type == json_token_type::string_value ||
-            type == json_token_type::int_value ||
-            type == json_token_type::double_value ||
-            type == json_token_type::bool_value ||
-            type == json_token_type::null_value;
-    }
+            const char* chars() const noexcept {
+                return reinterpret_cast<const char*>(this + 1);
+            }
+        };
 
-    struct json_token {
-        json_token_type type;
-        json_value value{};
-        bool is_valid{ true };
-        std::string error_str{};
-    };
+        static constexpr std::size_t tag_index_{ 15 };
+        static constexpr unsigned char shared_tag_{ 0x80 };
 
-    class json_lexer {
+        static entry_t* make_entry_(std::string_view text, std::size_t hash, std::uint64_t table,
+            std::pmr::memory_resource* resource) {
+            void* memory{ resource->allocate(sizeof(entry_t) + text.size(), alignof(entry_t)) };
+            entry_t* entry{ ::new (memory) entry_t{ {1}, static_cast<std::uint32_t>(text.size()), hash, table, resource } };
+            std::memcpy(entry->chars(), text.data(), text.size());
+            return entry;
+        }
+
+        static void release_(entry_t* entry) noexcept {
+            if (entry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::pmr::memory_resource* resource{ entry->resource };
+                std::size_t bytes{ sizeof(entry_t) + entry->size };
+                entry->~entry_t();
+                resource->deallocate(entry, bytes, alignof(entry_t));
+            }
+        }
+
+        bool is_shared_() const noexcept {
+            return bytes_[tag_index_] == shared_tag_;
+        }
+
+        entry_t* entry_() const noexcept {
+            entry_t* entry;
+            std::memcpy(&entry, bytes_, sizeof(entry));
+            return entry;
+        }
+
+        // Takes over one reference to entry
+        void set_entry_(entry_t* entry) noexcept {
+            std::memcpy(bytes_, &entry, sizeof(entry));
+            bytes_[tag_index_] = shared_tag_;
+        }
+
+    private:
+
+        alignas(8) unsigned char bytes_[16];
+
+    }; // class json_key
+
+    // Thread-safe intern table for object member names. Every distinct name longer than
+    // json_key::inline_capacity is stored once; keys handed out keep their entry alive, so the
+    // table may be destroyed before the documents that used it. Use one table per document
+    // family, or shared() for a process-wide one.
+    class json_key_table {
     public:
 
-        json_lexer() = delete;
-        json_lexer(const json_lexer&) = delete;
-        json_lexer(json_lexer&&) = delete;
-        json_lexer& operator=(const json_lexer&) = delete;
-        json_lexer& operator=(json_lexer&&) = delete;
+        json_key_table(const json_key_table&) = delete;
+        json_key_table(json_key_table&&) = delete;
+        json_key_table& operator=(const json_key_table&) = delete;
+        json_key_table& operator=(json_key_table&&) = delete;
 
     public:
 
-        explicit json_lexer(const std::string& src_str) :
-            pos_{ 0 },
-            source_{ src_str }
+        explicit json_key_table(std::pmr::memory_resource* resource = std::pmr::new_delete_resource()) :
+            id_{ next_id_() },
+            resource_{ resource }
         {
-
         }
 
-        json_token next_token() {
-            skip_whitespaces_();
-            if (pos_ >= source_.size()) {
-                return { json_token_type::end_of_file };
+        ~json_key_table() {
+            for (auto& [_, entry] : entries_) {
+                json_key::release_(entry);
             }
+        }
 
-            std::string::value_type ch{ peek_() };
+        static json_key_table& shared() {
+            static json_key_table* table{ new json_key_table() };
+            return *table;
+        }
 
-            switch (ch) {
-                case '{':
-                    advance_();
-                    return { json_token_type::left_brace };
-                case '}':
-                    advance_();
-                    return { json_token_type::right_brace };
-                case '[':
-                    advance_();
-                    return { json_token_type::left_bracket };
-                case ']':
-                    advance_();
-                    return { json_token_type::right_bracket };
-                case ':':
-                    advance_();
-                    return { json_token_type::colon };
-                case ',':
-                    advance_();
-                    return { json_token_type::comma };
-                case '"':
-                    return parse_string_();
+    public:
+
+        json_key intern(std::string_view text) {
+            if (text.size() <= json_key::inline_capacity) {
+                return json_key(text);
             }
+            json_key key;
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(text);
+            if (it == entries_.end()) {
+                json_key::entry_t* entry{ json_key::make_entry_(text, std::hash<std::string_view>{}(text), id_, resource_) };
+                it = entries_.emplace(std::string_view(entry->chars(), entry->size), entry).first;
+            }
+            it->second->refs.fetch_add(1, std::memory_order_relaxed);
+            key.set_entry_(it->second);
+            return key;
+        }
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return entries_.size();
+        }
+
+    private:
+
+        static std::uint64_t next_id_() noexcept {
+            static std::atomic<std::uint64_t> counter{ 0 };
+            return ++counter;
+        }
+
+    private:
 
-            if (std::isdigit(ch) || ch == '-') {
-                return parse_number_();
+        std::uint64_t id_;
+        std::pmr::memory_resource* resource_;
+        mutable std::mutex mutex_{};
+        std::unordered_map<std::string_view, json_key::entry_t*> entries_{};
+
+    }; // class json_key_table
+
+    // Insertion-ordered object. Members are stored contiguously in the order they were added,
+    // so iteration and serialization order is deterministic. Small objects are searched
+    // linearly; once an object grows past index_threshold members an open-addressing index of
+    // member positions is kept alongside. Keys must not be modified through iterators.
+    template <typename Value>
+    class basic_json_object {
+    public:
+
+        using key_type = json_key;
+        using mapped_type = Value;
+        using value_type = std::pair<json_key, Value>;
+        using size_type = std::size_t;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+        using container_type = std::pmr::vector<value_type>;
+        using iterator = typename container_type::iterator;
+        using const_iterator = typename container_type::const_iterator;
+
+        static constexpr size_type index_threshold{ 16 };
+
+    public:
+
+        basic_json_object() = default;
+
+        explicit basic_json_object(const allocator_type& alloc) :
+            members_(alloc),
+            index_(alloc)
+        {
+        }
+
+        basic_json_object(std::initializer_list<value_type> list, const allocator_type& alloc = {}) :
+            basic_json_object(alloc)
+        {
+            reserve(list.size());
+            for (const auto& member : list) {
+                try_emplace(member.first, member.second);
             }
+        }
 
-            static std::string true_str{ "true" };
-            static std::string false_str{ "false" };
-            static std::string null_str{ "null" };
+        basic_json_object(const basic_json_object&) = default;
+        basic_json_object(basic_json_object&&) noexcept = default;
+        basic_json_object& operator=(const basic_json_object&) = default;
+        basic_json_object& operator=(basic_json_object&&) noexcept = default;
 
-            if (starts_with_(true_str)) {
-                advance_(true_str.size());
-                return { json_token_type::bool_value,json_value(true) };
+    public:
+
+        allocator_type get_allocator() const noexcept {
+            return members_.get_allocator();
+        }
+
+        iterator begin() noexcept {
+            return members_.begin();
+        }
+
+        iterator end() noexcept {
+            return members_.end();
+        }
+
+        const_iterator begin() const noexcept {
+            return members_.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return members_.end();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return members_.cbegin();
+        }
+
+        const_iterator cend() const noexcept {
+            return members_.cend();
+        }
+
+        size_type size() const noexcept {
+            return members_.size();
+        }
+
+        bool empty() const noexcept {
+            return members_.empty();
+        }
+
+        void reserve(size_type count) {
+            members_.reserve(count);
+        }
+
+        void clear() noexcept {
+            members_.clear();
+            index_.clear();
+        }
+
+        // Lookups accept anything viewable as a string; a json_key compares by pointer when both
+        // sides were interned in the same table
+        template <concepts::is_key_like K>
+        iterator find(const K& key) {
+            size_type pos{ find_(key) };
+            return pos == npos_ ? end() : begin() + static_cast<std::ptrdiff_t>(pos);
+        }
+
+        template <concepts::is_key_like K>
+        const_iterator find(const K& key) const {
+            size_type pos{ find_(key) };
+            return pos == npos_ ? end() : begin() + static_cast<std::ptrdiff_t>(pos);
+        }
+
+        template <concepts::is_key_like K>
+        bool contains(const K& key) const {
+            return find_(key) != npos_;
+        }
+
+        template <concepts::is_key_like K>
+        size_type count(const K& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        template <concepts::is_key_like K>
+        Value& at(const K& key) {
+            size_type pos{ find_(key) };
+            if (pos == npos_) {
+                throw std::out_of_range("json_object::at: key not found");
             }
-            if (starts_with_(false_str)) {
-                advance_(false_str.size());
-                return { json_token_type::bool_value,json_value(false) };
+            return members_[pos].second;
+        }
+
+        template <concepts::is_key_like K>
+        const Value& at(const K& key) const {
+            size_type pos{ find_(key) };
+            if (pos == npos_) {
+                throw std::out_of_range("json_object::at: key not found");
             }
-            if (starts_with_(null_str)) {
-                advance_(null_str.size());
-                return { json_token_type::null_value, json_value(nullptr) };
+            return members_[pos].second;
+        }
+
+        template <concepts::is_key_like K>
+        Value& operator[](K&& key) {
+            return try_emplace(std::forward<K>(key)).first->second;
+        }
+
+        // Appends a member unless the key is already present
+        template <concepts::is_key_like K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            size_type pos{ find_(key) };
+            if (pos != npos_) {
+                return { begin() + static_cast<std::ptrdiff_t>(pos), false };
             }
-            return { json_token_type::invalid,json_value(nullptr),
-                     false, "Unexpected character: " + std::string(1, ch) };
+            members_.emplace_back(std::piecewise_construct,
+                std::forward_as_tuple(make_key_(std::forward<K>(key))),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            on_append_();
+            return { std::prev(end()), true };
         }
 
-    private:
+        template <concepts::is_key_like K, typename V>
+        std::pair<iterator, bool> emplace(K&& key, V&& value) {
+            return try_emplace(std::forward<K>(key), std::forward<V>(value));
+        }
 
-        json_token parse_number_() {
-            std::string result;
-            bool is_float = false;
+        std::pair<iterator, bool> insert(const value_type& member) {
+            return try_emplace(member.first, member.second);
+        }
 
-            if (peek_() == '-') {
-                result += '-';
-                advance_();
+        std::pair<iterator, bool> insert(value_type&& member) {
+            return try_emplace(std::move(member.first), std::move(member.second));
+        }
+
+        // Appends a member or replaces the value of an existing one in place
+        template <concepts::is_key_like K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!result.second) {
+                result.first->second = std::forward<V>(value);
             }
+            return result;
+        }
+
+        iterator erase(const_iterator pos) {
+            iterator next{ members_.erase(pos) };
+            reindex_();
+            return next;
+        }
 
-            if (pos_ >= source_.size() || !std::isdigit(peek_())) {
-                return { json_token_type::invalid, json_value(nullptr), false, "Invalid number format" };
+        template <concepts::is_key_like K>
+        size_type erase(const K& key) {
+            size_type pos{ find_(key) };
+            if (pos == npos_) {
+                return 0;
             }
+            erase(begin() + static_cast<std::ptrdiff_t>(pos));
+            return 1;
+        }
 
-            if (peek_() == '0') {
-                result += '0';
-                advance_();
-                if (pos_ < source_.size() && std::isdigit(peek_())) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Leading zeros are not allowed" };
-                }
+    private:
+
+        static constexpr size_type npos_{ static_cast<size_type>(-1) };
+
+        template <typename K>
+        json_key make_key_(K&& key) const {
+            if constexpr (std::is_same_v<std::remove_cvref_t<K>, json_key>) {
+                return std::forward<K>(key);
             }
             else {
-                while (pos_ < source_.size() && std::isdigit(peek_())) {
-                    result += peek_();
-                    advance_();
-                }
+                return json_key(std::string_view(key), members_.get_allocator().resource());
             }
+        }
 
-            if (peek_() == '.') {
-                is_float = true;
-                result += '.';
-                advance_();
-                if (pos_ >= source_.size() || !std::isdigit(peek_())) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Invalid number format after decimal point" };
-                }
-                while (pos_ < source_.size() && std::isdigit(peek_())) {
-                    result += peek_();
-                    advance_();
-                }
+        template <typename K>
+        size_type find_(const K& key) const noexcept {
+            if constexpr (std::is_same_v<K, json_key>) {
+                return probe_(key, [&] { return key.hash(); });
             }
-
-            if (peek_() == 'e' || peek_() == 'E') {
-                is_float = true;
-                result += peek_();
-                advance_();
-                if (peek_() == '+' || peek_() == '-') {
-                    result += peek_();
-                    advance_();
-                }
-                if (pos_ >= source_.size() || !std::isdigit(peek_())) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Invalid exponent format" };
-                }
-                while (pos_ < source_.size() && std::isdigit(peek_())) {
-                    result += peek_();
-                    advance_();
-                }
+            else {
+                std::string_view text(key);
+                return probe_(text, [&] { return std::hash<std::string_view>{}(text); });
             }
+        }
 
-            if (is_float) {
-                try {
-                    json_double_t value = std::stod(result);
-                    if (std::isnan(value) || std::isinf(value)) {
-                        return { json_token_type::invalid, json_value(nullptr), false, "Invalid float number (NaN or Infinity/Overflow)" };
-                    }
-                    if (value != 0.0 && std::fpclassify(value) == FP_SUBNORMAL) {
-                        return { json_token_type::invalid, json_value(nullptr), false, "Float underflow (subnormal value)" };
+        // The hash is only computed once the index exists
+        template <typename Key, typename HashFn>
+        size_type probe_(const Key& key, HashFn hash) const noexcept {
+            if (index_.empty()) {
+                for (size_type i = 0; i < members_.size(); ++i) {
+                    if (members_[i].first == key) {
+                        return i;
                     }
-                    return { json_token_type::double_value, json_value(value) };
-                }
-                catch (const std::exception&) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Invalid float number (parse error or overflow/underflow)" };
                 }
+                return npos_;
             }
-            else {
-                try {
-                    json_int_t value = std::stoll(result);
-                    return { json_token_type::int_value, json_value(value) };
+            std::size_t mask{ index_.size() - 1 };
+            for (std::size_t slot = hash() & mask; ; slot = (slot + 1) & mask) {
+                std::uint32_t entry{ index_[slot] };
+                if (entry == 0) {
+                    return npos_;
                 }
-                catch (const std::out_of_range&) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Integer overflow/underflow" };
-                }
-                catch (const std::exception&) {
-                    return { json_token_type::invalid, json_value(nullptr), false, "Invalid integer number" };
+                if (members_[entry - 1].first == key) {
+                    return entry - 1;
                 }
             }
         }
 
-        json_token parse_string_() {
-            std::string result;
-
-            advance_();
+        void index_insert_(size_type pos) noexcept {
+            std::size_t mask{ index_.size() - 1 };
+            std::size_t slot{ members_[pos].first.hash() & mask };
+            while (index_[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            index_[slot] = static_cast<std::uint32_t>(pos + 1);
+        }
 
-            while (pos_ < source_.size()) {
-                std::string::value_type ch{ peek_() };
+        void on_append_() {
+            if (members_.size() <= index_threshold) {
+                return;
+            }
+            // Keep the load factor at or below one half
+            if (members_.size() * 2 > index_.size()) {
+                reindex_();
+            }
+            else {
+                index_insert_(members_.size() - 1);
+            }
+        }
+
+        void reindex_() {
+            if (members_.size() <= index_threshold) {
+                index_.clear();
+                return;
+            }
+            index_.assign(std::bit_ceil(members_.size() * 4), 0);
+            for (size_type i = 0; i < members_.size(); ++i) {
+                index_insert_(i);
+            }
+        }
+
+    private:
+
+        container_type members_{};
+        std::pmr::vector<std::uint32_t> index_{};
+
+    }; // class basic_json_object
+
+    // Containers and strings take their memory from a std::pmr::memory_resource, the default
+    // resource unless the parser is given one (see json_parse_options::memory_resource)
+    using json_array = std::pmr::vector<json_value>;
+    using json_object = basic_json_object<json_value>;
+
+    namespace concepts {
+        template <typename T>
+        concept is_int = (std::is_integral_v<T> && !std::is_same_v<T, bool>);
+
+        template <typename T>
+        concept is_json_value =
+            std::is_same_v<T, json_null_t> ||
+            std::is_same_v<T, json_bool_t> ||
+            std::is_same_v<T, json_int_t> ||
+            std::is_same_v<T, json_double_t> ||
+            std::is_same_v<T, json_string_t> ||
+            std::is_same_v<T, json_array> ||
+            std::is_same_v<T, json_object> ||
+            std::is_same_v<T, const char*>;
+
+    } // namespace concepts
+
+    enum class json_type : std::uint8_t {
+        null,
+        boolean,
+        integer,
+        floating,
+        string,
+        array,
+        object
+    };
+
+    // Tag plus an 8-byte payload. Scalars live in place; strings, arrays and objects are boxed
+    // in storage obtained from their own allocator, so a json_array of numbers stays dense.
+    class json_value {
+    public:
+
+        json_value() noexcept = default;
+
+        template <typename T>
+            requires (concepts::is_json_value<T> || concepts::is_int<T>)
+        json_value(T value) {
+            if constexpr (concepts::is_int<T> || std::is_same_v<T, json_int_t>) {
+                payload_.int_value = static_cast<json_int_t>(value);
+                type_ = json_type::integer;
+            }
+            else if constexpr (std::is_same_v<T, json_bool_t>) {
+                payload_.bool_value = value;
+                type_ = json_type::boolean;
+            }
+            else if constexpr (std::is_same_v<T, json_double_t>) {
+                payload_.double_value = value;
+                type_ = json_type::floating;
+            }
+            else if constexpr (std::is_same_v<T, const char*>) {
+                payload_.string_value = box_(json_string_t(value));
+                type_ = json_type::string;
+            }
+            else if constexpr (!std::is_same_v<T, json_null_t>) {
+                get_ptr_<T>() = box_(std::move(value));
+                type_ = type_of_<T>();
+            }
+        }
+
+        json_value(json_null_t) noexcept
+        {
+        }
+
+        explicit json_value(const char* value) :
+            json_value(json_string_t(value))
+        {
+        }
+
+        json_value(std::string_view value) :
+            json_value(json_string_t(value))
+        {
+        }
+
+        json_value(const std::string& value) :
+            json_value(json_string_t(value))
+        {
+        }
+
+        explicit json_value(std::initializer_list<json_value> list)
+        {
+            if (list.size() == 1) {
+                *this = *(list.begin());
+            }
+            else {
+                json_array tmp;
+                tmp.reserve(list.size());
+                for (const auto& item : list) {
+                    tmp.push_back(item);
+                }
+                *this = json_value(std::move(tmp));
+            }
+        }
+
+        json_value(const json_value& other) :
+            payload_{ other.payload_ },
+            type_{ other.type_ }
+        {
+            switch (type_) {
+                case json_type::string:
+                    payload_.string_value = box_(json_string_t(*other.payload_.string_value));
+                    break;
+                case json_type::array:
+                    payload_.array_value = box_(json_array(*other.payload_.array_value));
+                    break;
+                case json_type::object:
+                    payload_.object_value = box_(json_object(*other.payload_.object_value));
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        json_value(json_value&& other) noexcept :
+            payload_{ other.payload_ },
+            type_{ std::exchange(other.type_, json_type::null) }
+        {
+        }
+
+        json_value& operator=(const json_value& other) {
+            if (this != &other) {
+                *this = json_value(other);
+            }
+            return *this;
+        }
+
+        // other may be owned by this value, so it is detached before the old payload is released
+        json_value& operator=(json_value&& other) noexcept {
+            payload_t payload{ other.payload_ };
+            json_type type{ std::exchange(other.type_, json_type::null) };
+            reset_();
+            payload_ = payload;
+            type_ = type;
+            return *this;
+        }
+
+        ~json_value() {
+            reset_();
+        }
+
+    public:
+
+        [[nodiscard]] json_type type() const noexcept {
+            return type_;
+        }
+
+        template <typename T>
+            requires (concepts::is_json_value<T>)
+        [[nodiscard]] T& as() {
+            if (!is<T>()) {
+                throw std::bad_variant_access{};
+            }
+            return get_<T>();
+        }
+
+        template <typename T>
+            requires (concepts::is_json_value<T>)
+        [[nodiscard]] const T& as() const {
+            if (!is<T>()) {
+                throw std::bad_variant_access{};
+            }
+            return const_cast<json_value*>(this)->get_<T>();
+        }
+
+        template <typename T>
+            requires (concepts::is_json_value<T>)
+        [[nodiscard]] T* try_as() {
+            return is<T>() ? &get_<T>() : nullptr;
+        }
+
+        template <typename T>
+            requires (concepts::is_json_value<T>)
+        [[nodiscard]] const T* try_as() const {
+            return is<T>() ? &const_cast<json_value*>(this)->get_<T>() : nullptr;
+        }
+
+        template <typename T>
+            requires (concepts::is_json_value<T>)
+        [[nodiscard]] bool is() const noexcept {
+            return type_ == type_of_<T>();
+        }
+
+    private:
+
+        union payload_t {
+            json_bool_t bool_value;
+            json_int_t int_value{ 0 };
+            json_double_t double_value;
+            json_string_t* string_value;
+            json_array* array_value;
+            json_object* object_value;
+        };
+
+        template <typename T>
+        static constexpr json_type type_of_() noexcept {
+            if constexpr (std::is_same_v<T, json_null_t>) return json_type::null;
+            else if constexpr (std::is_same_v<T, json_bool_t>) return json_type::boolean;
+            else if constexpr (std::is_same_v<T, json_int_t>) return json_type::integer;
+            else if constexpr (std::is_same_v<T, json_double_t>) return json_type::floating;
+            else if constexpr (std::is_same_v<T, json_string_t>) return json_type::string;
+            else if constexpr (std::is_same_v<T, json_array>) return json_type::array;
+            else if constexpr (std::is_same_v<T, json_object>) return json_type::object;
+            else static_assert(!sizeof(T), "not a stored json_value type");
+        }
+
+        template <typename T>
+        auto& get_ptr_() noexcept {
+            if constexpr (std::is_same_v<T, json_string_t>) return payload_.string_value;
+            else if constexpr (std::is_same_v<T, json_array>) return payload_.array_value;
+            else return payload_.object_value;
+        }
+
+        template <typename T>
+        T& get_() noexcept {
+            if constexpr (std::is_same_v<T, json_null_t>) {
+                static json_null_t null{};
+                return null;
+            }
+            else if constexpr (std::is_same_v<T, json_bool_t>) return payload_.bool_value;
+            else if constexpr (std::is_same_v<T, json_int_t>) return payload_.int_value;
+            else if constexpr (std::is_same_v<T, json_double_t>) return payload_.double_value;
+            else return *get_ptr_<T>();
+        }
+
+        // Moves value into a node allocated from its own memory resource; moving between equal
+        // resources does not throw
+        template <typename T>
+        static T* box_(T&& value) {
+            std::pmr::polymorphic_allocator<> alloc{ value.get_allocator().resource() };
+            T* node{ alloc.allocate_object<T>() };
+            return ::new (node) T(std::move(value));
+        }
+
+        template <typename T>
+        static void unbox_(T* node) noexcept {
+            std::pmr::polymorphic_allocator<> alloc{ node->get_allocator().resource() };
+            node->~T();
+            alloc.deallocate_object(node);
+        }
+
+        void reset_() noexcept {
+            switch (type_) {
+                case json_type::string:
+                    unbox_(payload_.string_value);
+                    break;
+                case json_type::array:
+                    unbox_(payload_.array_value);
+                    break;
+                case json_type::object:
+                    unbox_(payload_.object_value);
+                    break;
+                default:
+                    break;
+            }
+            type_ = json_type::null;
+        }
+
+    private:
+
+        payload_t payload_{};
+        json_type type_{ json_type::null };
+
+    }; // class json_value
+
+    enum class json_token_type : std::uint8_t {
+        invalid,
+        left_bracket, right_bracket,
+        left_brace, right_brace,
+        colon, comma,
+        string_value, int_value, double_value, bool_value, null_value,
+        end_of_file
+    };
+
+    constexpr bool is_value_token(json_token_type type) {
+        return type == json_token_type::string_value ||
+            type == json_token_type::int_value ||
+            type == json_token_type::double_value ||
+            type == json_token_type::bool_value ||
+            type == json_token_type::null_value;
+    }
+
+    enum class json_errc : std::uint8_t {
+        none,
+        unexpected_character,
+        invalid_number,
+        leading_zeros,
+        invalid_fraction,
+        invalid_exponent,
+        invalid_float,
+        float_not_finite,
+        float_underflow,
+        integer_overflow,
+        invalid_integer,
+        unterminated_escape,
+        incomplete_unicode_escape,
+        invalid_unicode_escape,
+        missing_low_surrogate,
+        invalid_low_surrogate_escape,
+        invalid_low_surrogate,
+        unexpected_low_surrogate,
+        invalid_code_point,
+        invalid_escape,
+        control_character,
+        unterminated_string,
+        empty_document,
+        unexpected_root_token,
+        trailing_content,
+        unexpected_left_brace,
+        dangling_comma_in_object,
+        unexpected_right_brace,
+        unexpected_left_bracket,
+        dangling_comma_in_array,
+        unexpected_right_bracket,
+        unexpected_end_of_file,
+        expected_string_key,
+        empty_key,
+        unexpected_value,
+        unexpected_comma,
+        unexpected_colon,
+        unexpected_token,
+        expected_colon,
+        expected_value,
+        max_depth_exceeded,
+        handler_aborted,
+        file_error
+    };
+
+    constexpr std::string_view error_text(json_errc code) noexcept {
+        switch (code) {
+            case json_errc::unexpected_character: return "Unexpected character: ";
+            case json_errc::invalid_number: return "Invalid number format";
+            case json_errc::leading_zeros: return "Leading zeros are not allowed";
+            case json_errc::invalid_fraction: return "Invalid number format after decimal point";
+            case json_errc::invalid_exponent: return "Invalid exponent format";
+            case json_errc::invalid_float: return "Invalid float number (parse error or overflow/underflow)";
+            case json_errc::float_not_finite: return "Invalid float number (NaN or Infinity/Overflow)";
+            case json_errc::float_underflow: return "Float underflow (subnormal value)";
+            case json_errc::integer_overflow: return "Integer overflow/underflow";
+            case json_errc::invalid_integer: return "Invalid integer number";
+            case json_errc::unterminated_escape: return "Unterminated string escape";
+            case json_errc::incomplete_unicode_escape: return "Incomplete \\u escape sequence";
+            case json_errc::invalid_unicode_escape: return "Invalid hex digit in \\u escape sequence";
+            case json_errc::missing_low_surrogate: return "Expected low surrogate after high surrogate";
+            case json_errc::invalid_low_surrogate_escape: return "Invalid hex digit in low surrogate";
+            case json_errc::invalid_low_surrogate: return "Invalid low surrogate in \\u escape sequence";
+            case json_errc::unexpected_low_surrogate: return "Unexpected low surrogate without preceding high surrogate";
+            case json_errc::invalid_code_point: return "Invalid Unicode code point in \\u escape sequence";
+            case json_errc::invalid_escape: return "Invalid escape sequence: \\";
+            case json_errc::control_character: return "Control character in string: ";
+            case json_errc::unterminated_string: return "Unterminated string";
+            case json_errc::empty_document: return "Empty JSON document";
+            case json_errc::unexpected_root_token: return "Unexpected token in root: ";
+            case json_errc::trailing_content: return "Unexpected tokens after JSON document end";
+            case json_errc::unexpected_left_brace: return "Unexpected left brace in array or object context";
+            case json_errc::dangling_comma_in_object: return "Dangling comma before right brace in object context";
+            case json_errc::unexpected_right_brace: return "Unexpected right brace in array context";
+            case json_errc::unexpected_left_bracket: return "Unexpected left bracket in array or object context";
+            case json_errc::dangling_comma_in_array: return "Dangling comma before right bracket in array context";
+            case json_errc::unexpected_right_bracket: return "Unexpected right bracket in object context";
+            case json_errc::unexpected_end_of_file: return "Unexpected end of file in array or object context";
+            case json_errc::expected_string_key: return "Expected string key in object context";
+            case json_errc::empty_key: return "Empty key in object context";
+            case json_errc::unexpected_value: return "Unexpected value in array or object context";
+            case json_errc::unexpected_comma: return "Unexpected comma in array or object context";
+            case json_errc::unexpected_colon: return "Unexpected colon in array or object context";
+            case json_errc::unexpected_token: return "Unexpected token in array: ";
+            case json_errc::expected_colon: return "Expected colon after key in object context";
+            case json_errc::expected_value: return "Expected value after colon in object context";
+            case json_errc::max_depth_exceeded: return "Maximum nesting depth exceeded";
+            case json_errc::handler_aborted: return "Parsing stopped by the handler";
+            case json_errc::file_error: return "Cannot open or map the file";
+            case json_errc::none: break;
+        }
+        return {};
+    }
+
+    // Codes whose message ends with the offending character
+    constexpr bool error_quotes_char(json_errc code) noexcept {
+        return code == json_errc::unexpected_character ||
+            code == json_errc::invalid_escape ||
+            code == json_errc::control_character ||
+            code == json_errc::unexpected_root_token ||
+            code == json_errc::unexpected_token;
+    }
+
+    struct json_error {
+        json_errc code{ json_errc::none };
+        std::size_t offset{ 0 };
+        char ch{ '\0' };
+
+        explicit operator bool() const noexcept {
+            return code != json_errc::none;
+        }
+
+        [[nodiscard]] std::string message() const {
+            std::string result{ error_text(code) };
+            if (error_quotes_char(code) && ch != '\0') {
+                result += ch;
+            }
+            return result;
+        }
+    };
+
+    // Trivially copyable token handed from json_lexer to json_parser. String values are not
+    // owned: string_data points into the source, or into the lexer's scratch buffer when the
+    // string had escapes, and stays valid until the next call to next_token().
+    struct json_token {
+        json_token_type type{ json_token_type::invalid };
+        json_errc error{ json_errc::none };
+        std::size_t offset{ 0 };
+        std::size_t length{ 0 };
+        union {
+            json_bool_t bool_value;
+            json_int_t int_value{ 0 };
+            json_double_t double_value;
+            const char* string_data;
+        };
+
+        std::string_view string_value() const noexcept {
+            return { string_data, length };
+        }
+    };
+
+    namespace detail {
+
+        enum class char_class : std::uint8_t {
+            invalid,
+            left_bracket, right_bracket,
+            left_brace, right_brace,
+            colon, comma,
+            quote, number, literal
+        };
+
+        constexpr std::array<char_class, 256> make_char_classes() {
+            std::array<char_class, 256> table{};
+            table['['] = char_class::left_bracket;
+            table[']'] = char_class::right_bracket;
+            table['{'] = char_class::left_brace;
+            table['}'] = char_class::right_brace;
+            table[':'] = char_class::colon;
+            table[','] = char_class::comma;
+            table['"'] = char_class::quote;
+            table['-'] = char_class::number;
+            for (unsigned char c = '0'; c <= '9'; ++c) {
+                table[c] = char_class::number;
+            }
+            table['t'] = char_class::literal;
+            table['f'] = char_class::literal;
+            table['n'] = char_class::literal;
+            return table;
+        }
+
+        inline constexpr std::array<char_class, 256> char_classes{ make_char_classes() };
+
+        // Second character of the escape sequence for each byte the serializer must escape,
+        // 'u' for \u00XX, 0 for bytes copied verbatim. Nonzero exactly where is_string_special is.
+        constexpr std::array<char, 256> make_escape_table() {
+            std::array<char, 256> table{};
+            for (std::size_t c = 0; c < 0x20; ++c) {
+                table[c] = 'u';
+            }
+            table['"'] = '"';
+            table['\\'] = '\\';
+            table['\b'] = 'b';
+            table['\f'] = 'f';
+            table['\n'] = 'n';
+            table['\r'] = 'r';
+            table['\t'] = 't';
+            return table;
+        }
+
+        inline constexpr std::array<char, 256> escape_table{ make_escape_table() };
+
+        constexpr bool is_space(char ch) noexcept {
+            return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+        }
+
+        constexpr bool is_scalar_end(char ch) noexcept {
+            return is_space(ch) || ch == ',' || ch == ']' || ch == '}' || ch == ':';
+        }
+
+        constexpr bool is_string_special(char ch) noexcept {
+            return ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20;
+        }
+
+        inline const char* skip_whitespace_scalar(const char* first, const char* last) noexcept {
+            while (first != last && is_space(*first)) {
+                ++first;
+            }
+            return first;
+        }
+
+        inline const char* find_string_special_scalar(const char* first, const char* last) noexcept {
+            while (first != last && !is_string_special(*first)) {
+                ++first;
+            }
+            return first;
+        }
+
+#if defined(JSON_HAS_SSE2)
+
+        inline const char* skip_whitespace_sse2(const char* first, const char* last) noexcept {
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i carriage = _mm_set1_epi8('\r');
+            const __m128i tab = _mm_set1_epi8('\t');
+            while (last - first >= 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                __m128i ws = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage), _mm_cmpeq_epi8(chunk, tab)));
+                unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFFu;
+                if (mask != 0) {
+                    return first + std::countr_zero(mask);
+                }
+                first += 16;
+            }
+            return skip_whitespace_scalar(first, last);
+        }
+
+        JSON_TARGET_AVX2 inline const char* skip_whitespace_avx2(const char* first, const char* last) noexcept {
+            const __m256i space = _mm256_set1_epi8(' ');
+            const __m256i newline = _mm256_set1_epi8('\n');
+            const __m256i carriage = _mm256_set1_epi8('\r');
+            const __m256i tab = _mm256_set1_epi8('\t');
+            while (last - first >= 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                __m256i ws = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, newline)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, carriage), _mm256_cmpeq_epi8(chunk, tab)));
+                std::uint32_t mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(ws));
+                if (mask != 0) {
+                    return first + std::countr_zero(mask);
+                }
+                first += 32;
+            }
+            return skip_whitespace_sse2(first, last);
+        }
+
+        inline const char* find_string_special_sse2(const char* first, const char* last) noexcept {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control_max = _mm_set1_epi8(0x1F);
+            while (last - first >= 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max);
+                __m128i special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), control);
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+                if (mask != 0) {
+                    return first + std::countr_zero(mask);
+                }
+                first += 16;
+            }
+            return find_string_special_scalar(first, last);
+        }
+
+        JSON_TARGET_AVX2 inline const char* find_string_special_avx2(const char* first, const char* last) noexcept {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i control_max = _mm256_set1_epi8(0x1F);
+            while (last - first >= 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control_max), control_max);
+                __m256i special = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)), control);
+                std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(special));
+                if (mask != 0) {
+                    return first + std::countr_zero(mask);
+                }
+                first += 32;
+            }
+            return find_string_special_sse2(first, last);
+        }
+
+        inline bool cpu_has_avx2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4]{};
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuid(info, 1);
+            bool os_saves_ymm{ (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6 };
+            __cpuidex(info, 7, 0);
+            return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+#endif // JSON_HAS_SSE2
+
+        using scan_fn = const char* (*)(const char*, const char*) noexcept;
+
+        inline scan_fn select_skip_whitespace() noexcept {
+#if defined(JSON_HAS_SSE2)
+            return cpu_has_avx2() ? &skip_whitespace_avx2 : &skip_whitespace_sse2;
+#else
+            return &skip_whitespace_scalar;
+#endif
+        }
+
+        inline scan_fn select_find_string_special() noexcept {
+#if defined(JSON_HAS_SSE2)
+            return cpu_has_avx2() ? &find_string_special_avx2 : &find_string_special_sse2;
+#else
+            return &find_string_special_scalar;
+#endif
+        }
+
+        // Returns the first non-whitespace character in [first, last) or last.
+        inline const char* skip_whitespace(const char* first, const char* last) noexcept {
+            // Compact documents rarely have more than one whitespace in a row
+            if (first == last || !is_space(*first)) {
+                return first;
+            }
+            if (++first == last || !is_space(*first)) {
+                return first;
+            }
+            static const scan_fn impl{ select_skip_whitespace() };
+            return impl(first, last);
+        }
+
+        // Returns the first '"', '\\' or control character in [first, last) or last.
+        inline const char* find_string_special(const char* first, const char* last) noexcept {
+            static const scan_fn impl{ select_find_string_special() };
+            return impl(first, last);
+        }
+
+        // Stage 1 of two-stage parsing. Each 64-byte block is classified into bitmasks, one bit per
+        // byte; escaped quotes are removed, string interiors found with a prefix XOR, and the
+        // offsets of everything stage 2 starts a token at are appended to the index.
+        struct block_masks {
+            std::uint64_t quote{ 0 };
+            std::uint64_t backslash{ 0 };
+            std::uint64_t op{ 0 };      // { } [ ] : ,
+            std::uint64_t space{ 0 };
+        };
+
+        inline block_masks classify_block_scalar(const char* block) noexcept {
+            block_masks masks{};
+            for (unsigned i = 0; i < 64; ++i) {
+                std::uint64_t bit{ std::uint64_t{ 1 } << i };
+                switch (block[i]) {
+                    case '"': masks.quote |= bit; break;
+                    case '\\': masks.backslash |= bit; break;
+                    case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+                    case ' ': case '\t': case '\n': case '\r': masks.space |= bit; break;
+                    default: break;
+                }
+            }
+            return masks;
+        }
+
+#if defined(JSON_HAS_SSE2)
+
+        inline block_masks classify_block_sse2(const char* block) noexcept {
+            block_masks masks{};
+            for (unsigned i = 0; i < 64; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+                auto eq = [&](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+                auto bits = [&](__m128i m) { return static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(m))) << i; };
+                masks.quote |= bits(eq('"'));
+                masks.backslash |= bits(eq('\\'));
+                masks.op |= bits(_mm_or_si128(_mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                    _mm_or_si128(eq(':'), eq(','))));
+                masks.space |= bits(_mm_or_si128(_mm_or_si128(eq(' '), eq('\t')), _mm_or_si128(eq('\n'), eq('\r'))));
+            }
+            return masks;
+        }
+
+        JSON_TARGET_AVX2 inline block_masks classify_block_avx2(const char* block) noexcept {
+            block_masks masks{};
+            for (unsigned i = 0; i < 64; i += 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                auto eq = [&](char c) JSON_TARGET_AVX2 { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)); };
+                auto bits = [&](__m256i m) JSON_TARGET_AVX2 { return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(m))) << i; };
+                masks.quote |= bits(eq('"'));
+                masks.backslash |= bits(eq('\\'));
+                masks.op |= bits(_mm256_or_si256(_mm256_or_si256(_mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq('['), eq(']'))),
+                    _mm256_or_si256(eq(':'), eq(','))));
+                masks.space |= bits(_mm256_or_si256(_mm256_or_si256(eq(' '), eq('\t')), _mm256_or_si256(eq('\n'), eq('\r'))));
+            }
+            return masks;
+        }
+
+#endif // JSON_HAS_SSE2
+
+        // Bit i set when an odd number of bits at or below i are set in x
+        constexpr std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+            x ^= x << 1;
+            x ^= x << 2;
+            x ^= x << 4;
+            x ^= x << 8;
+            x ^= x << 16;
+            x ^= x << 32;
+            return x;
+        }
+
+        // Carries between blocks: whether the first byte is escaped, inside a string, or continues
+        // an unquoted scalar
+        struct index_state {
+            std::uint64_t escaped{ 0 };
+            std::uint64_t in_string{ 0 };
+            std::uint64_t scalar{ 0 };
+        };
+
+        // Structural bits of one block: operators outside strings, opening quotes, and the first
+        // byte of every run of other non-whitespace bytes outside strings (numbers, literals and
+        // stray characters, which stage 2 reports as errors)
+        inline std::uint64_t structural_bits(const block_masks& masks, index_state& state) noexcept {
+            // Backslashes are rare, so escapes are resolved one backslash at a time
+            std::uint64_t escaped{ state.escaped };
+            state.escaped = 0;
+            for (std::uint64_t backslash = masks.backslash; backslash != 0; backslash &= backslash - 1) {
+                unsigned i{ static_cast<unsigned>(std::countr_zero(backslash)) };
+                if ((escaped >> i) & 1) {
+                    continue;
+                }
+                if (i == 63) {
+                    state.escaped = 1;
+                }
+                else {
+                    escaped |= std::uint64_t{ 1 } << (i + 1);
+                }
+            }
+            std::uint64_t quote{ masks.quote & ~escaped };
+            std::uint64_t in_string{ prefix_xor(quote) ^ state.in_string };
+            state.in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+            std::uint64_t outside{ ~in_string };
+            std::uint64_t scalar{ outside & ~(masks.op | masks.space | quote) };
+            std::uint64_t scalar_start{ scalar & ~((scalar << 1) | state.scalar) };
+            state.scalar = scalar >> 63;
+            return (masks.op & outside) | (quote & in_string) | scalar_start;
+        }
+
+        template <block_masks (*Classify)(const char*) noexcept>
+        void build_structural_index(std::string_view source, std::vector<std::uint32_t>& out) {
+            out.clear();
+            index_state state{};
+            std::size_t count{ 0 };
+            for (std::size_t base = 0; base < source.size(); base += 64) {
+                block_masks masks;
+                if (source.size() - base >= 64) {
+                    masks = Classify(source.data() + base);
+                }
+                else {
+                    // The tail is padded with spaces, which never produce structural bits
+                    char block[64];
+                    std::memset(block, ' ', sizeof(block));
+                    std::memcpy(block, source.data() + base, source.size() - base);
+                    masks = Classify(block);
+                }
+                std::uint64_t bits{ structural_bits(masks, state) };
+                if (out.size() < count + 64) {
+                    out.resize(std::max(count + 64, out.size() * 2));
+                }
+                std::uint32_t* it{ out.data() + count };
+                for (; bits != 0; bits &= bits - 1) {
+                    *it++ = static_cast<std::uint32_t>(base + static_cast<std::size_t>(std::countr_zero(bits)));
+                }
+                count = static_cast<std::size_t>(it - out.data());
+            }
+            out.resize(count);
+        }
+
+        using index_fn = void (*)(std::string_view, std::vector<std::uint32_t>&);
+
+        inline index_fn select_build_structural_index() noexcept {
+#if defined(JSON_HAS_SSE2)
+            return cpu_has_avx2() ? &build_structural_index<&classify_block_avx2> : &build_structural_index<&classify_block_sse2>;
+#else
+            return &build_structural_index<&classify_block_scalar>;
+#endif
+        }
+
+    } // namespace detail
+
+    // Offsets of the structural characters of a source: operators outside strings, the opening
+    // quote of every string and the first byte of every number or literal. Built by a SIMD pass
+    // that does not decode anything; json_parser and json_ondemand_document consume it as the
+    // second stage. Offsets are 32-bit, larger sources are not indexed.
+    class json_structural_index {
+    public:
+
+        static constexpr std::size_t max_source_size{ UINT32_MAX };
+
+    public:
+
+        json_structural_index() = default;
+
+        explicit json_structural_index(std::string_view source) {
+            build(source);
+        }
+
+    public:
+
+        // Replaces the index with the one of source, keeping capacity. Returns false, leaving
+        // the index empty, when source is larger than max_source_size.
+        bool build(std::string_view source) {
+            offsets_.clear();
+            if (source.size() > max_source_size) {
+                return false;
+            }
+            static const detail::index_fn impl{ detail::select_build_structural_index() };
+            impl(source, offsets_);
+            return true;
+        }
+
+        const std::vector<std::uint32_t>& offsets() const noexcept {
+            return offsets_;
+        }
+
+        std::size_t size() const noexcept {
+            return offsets_.size();
+        }
+
+        bool empty() const noexcept {
+            return offsets_.empty();
+        }
+
+    private:
+
+        std::vector<std::uint32_t> offsets_{};
+
+    }; // class json_structural_index
+
+    class json_lexer {
+    public:
+
+        json_lexer() = delete;
+        json_lexer(const json_lexer&) = delete;
+        json_lexer(json_lexer&&) = delete;
+        json_lexer& operator=(const json_lexer&) = delete;
+        json_lexer& operator=(json_lexer&&) = delete;
+
+    public:
+
+        explicit json_lexer(std::string_view src_str) :
+            pos_{ 0 },
+            source_{ src_str }
+        {
+
+        }
+
+        json_token next_token() {
+            skip_whitespaces_();
+            token_start_ = pos_;
+            if (pos_ >= source_.size()) {
+                return token_(json_token_type::end_of_file);
+            }
+
+            char ch{ peek_() };
+
+            switch (detail::char_classes[static_cast<unsigned char>(ch)]) {
+                case detail::char_class::left_brace:
+                    advance_();
+                    return token_(json_token_type::left_brace);
+                case detail::char_class::right_brace:
+                    advance_();
+                    return token_(json_token_type::right_brace);
+                case detail::char_class::left_bracket:
+                    advance_();
+                    return token_(json_token_type::left_bracket);
+                case detail::char_class::right_bracket:
+                    advance_();
+                    return token_(json_token_type::right_bracket);
+                case detail::char_class::colon:
+                    advance_();
+                    return token_(json_token_type::colon);
+                case detail::char_class::comma:
+                    advance_();
+                    return token_(json_token_type::comma);
+                case detail::char_class::quote:
+                    return parse_string_();
+                case detail::char_class::number:
+                    return parse_number_();
+                case detail::char_class::literal:
+                    break;
+                case detail::char_class::invalid:
+                    return error_(json_errc::unexpected_character);
+            }
+
+            constexpr std::string_view true_str{ "true" };
+            constexpr std::string_view false_str{ "false" };
+            constexpr std::string_view null_str{ "null" };
+
+            if (starts_with_(true_str)) {
+                advance_(true_str.size());
+                json_token token{ token_(json_token_type::bool_value) };
+                token.bool_value = true;
+                return token;
+            }
+            if (starts_with_(false_str)) {
+                advance_(false_str.size());
+                json_token token{ token_(json_token_type::bool_value) };
+                token.bool_value = false;
+                return token;
+            }
+            if (starts_with_(null_str)) {
+                advance_(null_str.size());
+                return token_(json_token_type::null_value);
+            }
+            return error_(json_errc::unexpected_character);
+        }
+
+        // Lexes the token that starts at pos, an offset from a json_structural_index
+        json_token next_token_at(std::size_t pos) {
+            pos_ = pos;
+            return next_token();
+        }
+
+        // True when the last token stopped inside a run of unquoted bytes. Stage 1 indexes only
+        // the first byte of such a run, so the rest (as in "1x" or "2-3") has to be lexed in place.
+        bool in_unindexed_run() const noexcept {
+            if (pos_ >= source_.size() || pos_ == token_start_) {
+                return false;
+            }
+            char ch{ source_[pos_] };
+            detail::char_class cls{ detail::char_classes[static_cast<unsigned char>(ch)] };
+            return !detail::is_space(ch) && (cls == detail::char_class::number ||
+                cls == detail::char_class::literal || cls == detail::char_class::invalid);
+        }
+
+        std::size_t position() const noexcept {
+            return pos_;
+        }
+
+        // Offset of the last token, or of the token that failed to lex
+        std::size_t token_start() const noexcept {
+            return token_start_;
+        }
+
+        // Continues lexing over another source from pos, keeping the escape buffer's capacity
+        void reset(std::string_view src_str, std::size_t pos = 0) noexcept {
+            source_ = src_str;
+            pos_ = pos;
+            token_start_ = pos;
+        }
+
+        std::string_view source() const noexcept {
+            return source_;
+        }
+
+    private:
+
+        json_token parse_number_() {
+            std::size_t start{ pos_ };
+            bool is_float = false;
+
+            if (peek_() == '-') {
+                advance_();
+            }
+
+            if (!is_digit_(peek_())) {
+                return error_(json_errc::invalid_number);
+            }
+
+            if (peek_() == '0') {
+                advance_();
+                if (is_digit_(peek_())) {
+                    return error_(json_errc::leading_zeros);
+                }
+            }
+            else {
+                skip_digits_();
+            }
+
+            if (peek_() == '.') {
+                is_float = true;
+                advance_();
+                if (!is_digit_(peek_())) {
+                    return error_(json_errc::invalid_fraction);
+                }
+                skip_digits_();
+            }
+
+            if (peek_() == 'e' || peek_() == 'E') {
+                is_float = true;
+                advance_();
+                if (peek_() == '+' || peek_() == '-') {
+                    advance_();
+                }
+                if (!is_digit_(peek_())) {
+                    return error_(json_errc::invalid_exponent);
+                }
+                skip_digits_();
+            }
+
+            const char* first{ source_.data() + start };
+            const char* last{ source_.data() + pos_ };
+
+            if (is_float) {
+                json_double_t value{};
+                auto [ptr, ec] = std::from_chars(first, last, value);
+                if (ec != std::errc{} || ptr != last) {
+                    return error_(json_errc::invalid_float);
+                }
+                if (std::isnan(value) || std::isinf(value)) {
+                    return error_(json_errc::float_not_finite);
+                }
+                if (value != 0.0 && std::fpclassify(value) == FP_SUBNORMAL) {
+                    return error_(json_errc::float_underflow);
+                }
+                json_token token{ token_(json_token_type::double_value) };
+                token.double_value = value;
+                return token;
+            }
+            else {
+                json_int_t value{};
+                auto [ptr, ec] = std::from_chars(first, last, value);
+                if (ec == std::errc::result_out_of_range) {
+                    return error_(json_errc::integer_overflow);
+                }
+                if (ec != std::errc{} || ptr != last) {
+                    return error_(json_errc::invalid_integer);
+                }
+                json_token token{ token_(json_token_type::int_value) };
+                token.int_value = value;
+                return token;
+            }
+        }
+
+        json_token parse_string_() {
+            advance_();
+
+            const char* begin{ source_.data() };
+            const char* end{ begin + source_.size() };
+            const char* run_end{ detail::find_string_special(begin + pos_, end) };
+
+            // No escapes: the token refers to the source directly
+            if (run_end != end && *run_end == '"') {
+                std::size_t first{ pos_ };
+                pos_ = static_cast<std::size_t>(run_end - begin) + 1;
+                return string_token_(begin + first, static_cast<std::size_t>(run_end - begin) - first);
+            }
+
+            std::string& result{ scratch_ };
+            result.assign(begin + pos_, run_end);
+            pos_ = static_cast<std::size_t>(run_end - begin);
+
+            while (pos_ < source_.size()) {
+                char ch{ peek_() };
+
+                if (!detail::is_string_special(ch)) {
+                    run_end = detail::find_string_special(begin + pos_, end);
+                    result.append(begin + pos_, run_end);
+                    pos_ = static_cast<std::size_t>(run_end - begin);
+                    continue;
+                }
+
+                if (ch == '"') {
+                    advance_();
+                    return string_token_(result.data(), result.size());
+                }
+
+                if (ch == '\\') {
+                    advance_();
+                    if (pos_ >= source_.size()) {
+                        return error_(json_errc::unterminated_escape);
+                    }
+
+                    char esc = peek_();
+                    switch (esc) {
+                        case '"': result += '"'; break;
+                        case '\\': result += '\\'; break;
+                        case '/': result += '/'; break;
+                        case 'b': result += '\b'; break;
+                        case 'f': result += '\f'; break;
+                        case 'n': result += '\n'; break;
+                        case 'r': result += '\r'; break;
+                        case 't': result += '\t'; break;
+                        case 'u': {
+                            advance_();
+                            if (pos_ + 4 > source_.size()) {
+                                return error_(json_errc::incomplete_unicode_escape);
+                            }
+                            std::uint16_t code_unit{ 0 };
+                            if (!parse_hex4_(code_unit)) {
+                                return error_(json_errc::invalid_unicode_escape);
+                            }
+                            advance_(4);
+
+                            std::uint32_t codepoint = 0;
+                            if (code_unit >= 0xD800 && code_unit <= 0xDBFF) {
+                                if (pos_ + 6 > source_.size() || source_[pos_] != '\\' || source_[pos_ + 1] != 'u') {
+                                    return error_(json_errc::missing_low_surrogate);
+                                }
+                                advance_(2);
+                                std::uint16_t low{ 0 };
+                                if (!parse_hex4_(low)) {
+                                    return error_(json_errc::invalid_low_surrogate_escape);
+                                }
+                                if (low < 0xDC00 || low > 0xDFFF) {
+                                    return error_(json_errc::invalid_low_surrogate);
+                                }
+                                codepoint = 0x10000 + (((code_unit - 0xD800) << 10) | (low - 0xDC00));
+                                advance_(4);
+                            }
+                            else if (code_unit >= 0xDC00 && code_unit <= 0xDFFF) {
+                                return error_(json_errc::unexpected_low_surrogate);
+                            }
+                            else {
+                                codepoint = code_unit;
+                            }
+                            if (!encode_utf8_(codepoint, result)) {
+                                return error_(json_errc::invalid_code_point);
+                            }
+                            continue;
+                        }
+                        default:
+                            return error_(json_errc::invalid_escape);
+                    }
+                    advance_();
+                }
+                else {
+                    return error_(json_errc::control_character);
+                }
+            }
+
+            return error_(json_errc::unterminated_string);
+        }
+
+        inline bool encode_utf8_(std::uint32_t codepoint, std::string& out) {
+            if (codepoint <= 0x7F) {
+                out += static_cast<char>(codepoint);
+                return true;
+            }
+            if (codepoint <= 0x7FF) {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+                return true;
+            }
+            if (codepoint <= 0xFFFF) {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+                return true;
+            }
+            if (codepoint <= 0x10FFFF) {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+                return true;
+            }
+            return false;
+        }
+
+        bool parse_hex4_(std::uint16_t& out) const noexcept {
+            const char* first{ source_.data() + pos_ };
+            auto [ptr, ec] = std::from_chars(first, first + 4, out, 16);
+            return ec == std::errc{} && ptr == first + 4;
+        }
+
+        json_token token_(json_token_type type) const noexcept {
+            json_token token{};
+            token.type = type;
+            token.offset = token_start_;
+            token.length = pos_ - token_start_;
+            return token;
+        }
+
+        json_token string_token_(const char* data, std::size_t size) const noexcept {
+            json_token token{ token_(json_token_type::string_value) };
+            token.string_data = data;
+            token.length = size;
+            return token;
+        }
+
+        json_token error_(json_errc code) const noexcept {
+            json_token token{};
+            token.error = code;
+            token.offset = pos_;
+            return token;
+        }
+
+        inline bool starts_with_(std::string_view value) const {
+            std::size_t size{ source_.size() };
+            if (pos_ + value.size() > size) {
+                return false;
+            }
+            return source_.compare(pos_, value.size(), value) == 0;
+        }
+
+        static constexpr bool is_digit_(char ch) noexcept {
+            return ch >= '0' && ch <= '9';
+        }
+
+        void skip_digits_() noexcept {
+            while (pos_ < source_.size() && is_digit_(source_[pos_])) {
+                pos_++;
+            }
+        }
+
+        void advance_(std::size_t count = 1) noexcept {
+            pos_ += count;
+        }
+
+        char peek_() const noexcept {
+            return pos_ < source_.size() ? source_[pos_] : '\0';
+        }
+
+        void skip_whitespaces_() noexcept {
+            const char* begin{ source_.data() };
+            pos_ = static_cast<std::size_t>(detail::skip_whitespace(begin + pos_, begin + source_.size()) - begin);
+        }
+
+    private:
+
+        std::size_t pos_;
+        std::size_t token_start_{ 0 };
+        std::string_view source_;
+        std::string scratch_{};
+
+    }; // class json_lexer
+
+    struct json_parse_options {
+        std::size_t max_depth{ 512 };
+        // Source of every string and container of the parsed tree, nullptr for the default
+        // resource. Pass a std::pmr::monotonic_buffer_resource to give a document a single
+        // arena that is released in one shot; it must outlive the parsed values.
+        std::pmr::memory_resource* memory_resource{ nullptr };
+        // Interns object member names longer than json_key::inline_capacity so that documents
+        // sharing a schema share their keys, nullptr to give every long key its own entry.
+        // The table may be shared between parsers and threads.
+        json_key_table* key_table{ nullptr };
+        // Builds a json_structural_index first and lexes only at its offsets, instead of
+        // discovering structure and decoding values in one interleaved pass
+        bool two_stage{ false };
+    };
+
+    namespace concepts {
+        // Receiver of json_parser events. Every callback returns false to stop the parse.
+        template <typename H>
+        concept is_json_handler = requires(H& handler, std::string_view text) {
+            { handler.on_null() } -> std::convertible_to<bool>;
+            { handler.on_bool(json_bool_t{}) } -> std::convertible_to<bool>;
+            { handler.on_int(json_int_t{}) } -> std::convertible_to<bool>;
+            { handler.on_double(json_double_t{}) } -> std::convertible_to<bool>;
+            { handler.on_string(text) } -> std::convertible_to<bool>;
+            { handler.on_key(text) } -> std::convertible_to<bool>;
+            { handler.start_object() } -> std::convertible_to<bool>;
+            { handler.end_object() } -> std::convertible_to<bool>;
+            { handler.start_array() } -> std::convertible_to<bool>;
+            { handler.end_array() } -> std::convertible_to<bool>;
+        };
+
+    } // namespace concepts
+
+    // Handler that builds a json_value tree; json_parser::parse() is this handler driven over the
+    // document. Children are collected on contiguous stacks and every container is allocated
+    // once at its final size. Completed root values are left for take_root().
+    class json_dom_builder {
+    public:
+
+        json_dom_builder(const json_dom_builder&) = delete;
+        json_dom_builder(json_dom_builder&&) = delete;
+        json_dom_builder& operator=(const json_dom_builder&) = delete;
+        json_dom_builder& operator=(json_dom_builder&&) = delete;
+
+    public:
+
+        explicit json_dom_builder(const json_parse_options& options = {}) :
+            allocator_{ options.memory_resource ? options.memory_resource : std::pmr::get_default_resource() },
+            key_table_{ options.key_table }
+        {
+        }
+
+    public:
+
+        bool on_null() {
+            values_.emplace_back(nullptr);
+            return true;
+        }
+
+        bool on_bool(json_bool_t value) {
+            values_.emplace_back(value);
+            return true;
+        }
+
+        bool on_int(json_int_t value) {
+            values_.emplace_back(value);
+            return true;
+        }
+
+        bool on_double(json_double_t value) {
+            values_.emplace_back(value);
+            return true;
+        }
+
+        bool on_string(std::string_view value) {
+            values_.emplace_back(json_string_t(value, allocator_));
+            return true;
+        }
+
+        bool on_key(std::string_view key) {
+            keys_.push_back(key_table_ ? key_table_->intern(key) : json_key(key, allocator_.resource()));
+            return true;
+        }
+
+        bool start_object() {
+            return start_();
+        }
+
+        bool start_array() {
+            return start_();
+        }
+
+        bool end_object() {
+            frame_t frame{ frames_.back() };
+            frames_.pop_back();
+            auto first = values_.begin() + static_cast<std::ptrdiff_t>(frame.first);
+            json_object object(allocator_);
+            object.reserve(values_.size() - frame.first);
+            auto key = keys_.begin() + static_cast<std::ptrdiff_t>(frame.first_key);
+            for (auto it = first; it != values_.end(); ++it, ++key) {
+                object.insert_or_assign(std::move(*key), std::move(*it));
+            }
+            keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(frame.first_key), keys_.end());
+            values_.erase(first, values_.end());
+            values_.emplace_back(std::move(object));
+            return true;
+        }
+
+        bool end_array() {
+            frame_t frame{ frames_.back() };
+            frames_.pop_back();
+            auto first = values_.begin() + static_cast<std::ptrdiff_t>(frame.first);
+            json_value node(json_array(std::make_move_iterator(first), std::make_move_iterator(values_.end()), allocator_));
+            values_.erase(first, values_.end());
+            values_.push_back(std::move(node));
+            return true;
+        }
+
+        // Removes and returns the most recently completed root value
+        [[nodiscard]] json_value take_root() {
+            json_value root(std::move(values_.back()));
+            values_.pop_back();
+            return root;
+        }
+
+        // Drops the state of an abandoned parse, keeping capacity
+        void clear() noexcept {
+            frames_.clear();
+            values_.clear();
+            keys_.clear();
+        }
+
+    private:
+
+        // Open container, its children are collected on values_ (and keys_) from index first
+        struct frame_t {
+            std::size_t first{ 0 };
+            std::size_t first_key{ 0 };
+        };
+
+        bool start_() {
+            if (frames_.capacity() == 0) {
+                frames_.reserve(32);
+                values_.reserve(256);
+                keys_.reserve(64);
+            }
+            frames_.push_back({ values_.size(), keys_.size() });
+            return true;
+        }
+
+    private:
+
+        std::pmr::polymorphic_allocator<> allocator_;
+        json_key_table* key_table_;
+        std::vector<frame_t> frames_{};
+        std::vector<json_value> values_{};
+        std::vector<json_key> keys_{};
+
+    }; // class json_dom_builder
+
+    // Handler that accepts every event: driving it only checks the grammar, and handlers that
+    // need a few events can derive from it and hide the rest
+    struct json_null_handler {
+        bool on_null() noexcept { return true; }
+        bool on_bool(json_bool_t) noexcept { return true; }
+        bool on_int(json_int_t) noexcept { return true; }
+        bool on_double(json_double_t) noexcept { return true; }
+        bool on_string(std::string_view) noexcept { return true; }
+        bool on_key(std::string_view) noexcept { return true; }
+        bool start_object() noexcept { return true; }
+        bool end_object() noexcept { return true; }
+        bool start_array() noexcept { return true; }
+        bool end_array() noexcept { return true; }
+    };
+
+    class json_parser {
+    public:
+
+        json_parser() = delete;
+        json_parser(const json_parser&) = delete;
+        json_parser(json_parser&&) = delete;
+        json_parser& operator=(const json_parser&) = delete;
+        json_parser& operator=(json_parser&&) = delete;
+
+    public:
+
+        explicit json_parser(std::string_view src_str, const json_parse_options& options = {}) :
+            lexer_{ src_str },
+            options_{ options },
+            builder_{ options }
+        {
+            if (options.two_stage && own_index_.build(src_str)) {
+                use_index_(own_index_);
+            }
+        }
+
+        // Second stage over an index already built for src_str, which must outlive the parser
+        json_parser(std::string_view src_str, const json_structural_index& index, const json_parse_options& options = {}) :
+            lexer_{ src_str },
+            options_{ options },
+            builder_{ options }
+        {
+            use_index_(index);
+        }
+
+        json_parser(const char* data, std::size_t size, const json_parse_options& options = {}) :
+            json_parser(std::string_view(data, size), options)
+        {
+
+        }
+
+        [[nodiscard]] json_value parse() {
+            builder_.clear();
+            if (!parse(builder_)) {
+                return json_value(nullptr);
+            }
+            return builder_.take_root();
+        }
+
+        // Reports the document to handler as a sequence of events instead of building a tree.
+        // String views passed to the handler are only valid during the call. Returns false on a
+        // syntax error, or with json_errc::handler_aborted when a callback returned false.
+        template <concepts::is_json_handler Handler>
+        bool parse(Handler& handler) {
+            return parse_value_(handler, next_token_()) && expect_end_();
+        }
+
+        // Parses the next of several values written back to back in the source, as in
+        // {"a":1}{"a":2} or 1 2 [3]. The lexer, the index and every buffer carry over from one
+        // value to the next. Returns false at the end of the source, where is_valid() stays true,
+        // or on an error. Adjacent numbers and literals must be separated by whitespace.
+        bool parse_next(json_value& value) {
+            builder_.clear();
+            if (!parse_next(builder_)) {
+                return false;
+            }
+            value = builder_.take_root();
+            return true;
+        }
+
+        template <concepts::is_json_handler Handler>
+        bool parse_next(Handler& handler) {
+            if (!is_valid_) {
+                return false;
+            }
+            json_token token{ next_token_() };
+            if (token.type == json_token_type::end_of_file) {
+                return false;
+            }
+            // Strings are delimited by their quotes, only a number or literal can run into the next value
+            bool is_scalar{ is_value_token(token.type) && token.type != json_token_type::string_value };
+            if (!parse_value_(handler, token)) {
+                return false;
+            }
+            if (is_scalar && lexer_.in_unindexed_run()) {
+                return fail_(json_errc::trailing_content, lexer_.position());
+            }
+            consumed_ = lexer_.position();
+            return true;
+        }
+
+        // Offset just past the last value returned by parse_next()
+        std::size_t consumed() const noexcept {
+            return consumed_;
+        }
+
+        // Checks the whole document with the same rules as parse() without building a tree;
+        // nothing is allocated beyond the frame stack and the lexer's escape buffer
+        bool validate() {
+            json_null_handler handler;
+            return parse(handler);
+        }
+
+        bool is_valid() const {
+            return is_valid_;
+        }
+
+        const json_error& error() const {
+            return error_;
+        }
+
+        // Message text is only built on request, the parse path records a code and an offset
+        const std::string& error_message() const {
+            if (error_message_.empty() && error_) {
+                error_message_ = error_.message();
+            }
+            return error_message_;
+        }
+
+
+    private:
+
+        friend class json_push_parser;
+
+        enum class expect_t : std::uint8_t {
+            first_value,    // after '[': value or ']'
+            value,          // after ',' in an array or ':' in an object
+            first_key,      // after '{': key or '}'
+            key,            // after ',' in an object
+            colon,
+            comma_or_end
+        };
+
+        enum class step_t : std::uint8_t {
+            more,       // the value continues with the next token
+            done,       // the handler received a complete root value
+            failed
+        };
+
+        template <typename Handler>
+        static bool emit_value_(Handler& handler, const json_token& token) {
+            switch (token.type) {
+                case json_token_type::string_value:
+                    return handler.on_string(token.string_value());
+                case json_token_type::int_value:
+                    return handler.on_int(token.int_value);
+                case json_token_type::double_value:
+                    return handler.on_double(token.double_value);
+                case json_token_type::bool_value:
+                    return handler.on_bool(token.bool_value);
+                default:
+                    return handler.on_null();
+            }
+        }
+
+        void log_error_(json_errc code, std::size_t offset) {
+            if (!is_valid_) {
+                return;
+            }
+            is_valid_ = false;
+            std::string_view source{ lexer_.source() };
+            error_ = { code, base_offset_ + offset, offset < source.size() ? source[offset] : '\0' };
+        }
 
-                if (ch == '"') {
-                    advance_();
-                    return { json_token_type::string_value, json_value(std::move(result)) };
+        bool fail_(json_errc code, std::size_t offset) {
+            log_error_(code, offset);
+            return false;
+        }
+
+        step_t stop_(json_errc code, std::size_t offset) {
+            log_error_(code, offset);
+            return step_t::failed;
+        }
+
+        void use_index_(const json_structural_index& index) noexcept {
+            cursor_ = index.offsets().data();
+            cursor_end_ = cursor_ + index.size();
+        }
+
+        json_token next_token_() {
+            if (cursor_ == nullptr) {
+                return lexer_.next_token();
+            }
+            if (lexer_.in_unindexed_run()) {
+                json_token token{ lexer_.next_token() };
+                while (cursor_ != cursor_end_ && *cursor_ < lexer_.position()) {
+                    ++cursor_;
                 }
+                return token;
+            }
+            return lexer_.next_token_at(cursor_ != cursor_end_ ? *cursor_++ : lexer_.source().size());
+        }
 
-                if (ch == '\\') {
-                    advance_();
-                    if (pos_ >= source_.size()) {
-                        return { json_token_type::invalid, json_value(nullptr),
-                                 false, "Unterminated string escape" };
-                    }
+        bool expect_end_() {
+            json_token token = next_token_();
+            if (token.type != json_token_type::end_of_file) {
+                return fail_(json_errc::trailing_content, token.offset);
+            }
+            return true;
+        }
 
-                    char esc = peek_();
-                    switch (esc) {
-                        case '"': result += '"'; break;
-                        case '\\': result += '\\'; break;
-                        case '/': result += '/'; break;
-                        case 'b': result += '\b'; break;
-                        case 'f': result += '\f'; break;
-                        case 'n': result += '\n'; break;
-                        case 'r': result += '\r'; break;
-                        case 't': result += '\t'; break;
-                        case 'u': {
-                            advance_();
-                            if (pos_ + 4 > source_.size()) {
-                                return { json_token_type::invalid, json_value(nullptr),
-                                         false, "Incomplete \\u escape sequence" };
-                            }
-                            std::string hex{ source_.substr(pos_, 4) };
-                            for (char c : hex) {
-                                if (!std::isxdigit(static_cast<unsigned char>(c))) {
-                                    return { json_token_type::invalid, json_value(nullptr),
-                                             false, "Invalid hex digit in \\u escape sequence" };
-                                }
-                            }
-                            std::uint16_t code_unit = static_cast<std::uint16_t>(std::stoi(hex, nullptr, 16));
-                            advance_(4);
+        template <typename Handler>
+        step_t open_(Handler& handler, bool is_object, std::size_t offset) {
+            if (frames_.size() >= options_.max_depth) {
+                return stop_(json_errc::max_depth_exceeded, offset);
+            }
+            if (!(is_object ? handler.start_object() : handler.start_array())) {
+                return stop_(json_errc::handler_aborted, offset);
+            }
+            frames_.push_back({ is_object });
+            expect_ = is_object ? expect_t::first_key : expect_t::first_value;
+            return step_t::more;
+        }
 
-                            std::uint32_t codepoint = 0;
-                            if (code_unit >= 0xD800 && code_unit <= 0xDBFF) {
-                                if (pos_ + 6 > source_.size() || source_[pos_] != '\\' || source_[pos_ + 1] != 'u') {
-                                    return { json_token_type::invalid, json_value(nullptr),
-                                             false, "Expected low surrogate after high surrogate" };
-                                }
-                                advance_(2);
-                                std::string hex2{ source_.substr(pos_, 4) };
-                                for (char c : hex2) {
-                                    if (!std::isxdigit(static_cast<unsigned char>(c))) {
-                                        return { json_token_type::invalid, json_value(nullptr),
-                                                 false, "Invalid hex digit in low surrogate" };
-                                    }
-                                }
-                                std::uint16_t low = static_cast<std::uint16_t>(std::stoi(hex2, nullptr, 16));
-                                if (low < 0xDC00 || low > 0xDFFF) {
-                                    return { json_token_type::invalid, json_value(nullptr),
-                                             false, "Invalid low surrogate in \\u escape sequence" };
-                                }
-                                codepoint = 0x10000 + (((code_unit - 0xD800) << 10) | (low - 0xDC00));
-                                advance_(4);
-                            }
-                            else if (code_unit >= 0xDC00 && code_unit <= 0xDFFF) {
-                                return { json_token_type::invalid, json_value(nullptr),
-                                         false, "Unexpected low surrogate without preceding high surrogate" };
-                            }
-                            else {
-                                codepoint = code_unit;
-                            }
-                            if (!encode_utf8_(codepoint, result)) {
-                                return { json_token_type::invalid, json_value(nullptr),
-                                         false, "Invalid Unicode code point in \\u escape sequence" };
-                            }
-                            continue;
+        template <typename Handler>
+        step_t close_(Handler& handler, bool is_object, std::size_t offset) {
+            frames_.pop_back();
+            if (!(is_object ? handler.end_object() : handler.end_array())) {
+                return stop_(json_errc::handler_aborted, offset);
+            }
+            expect_ = expect_t::comma_or_end;
+            return frames_.empty() ? step_t::done : step_t::more;
+        }
+
+        // Advances the grammar by one token; the whole parse state lives in frames_ and expect_,
+        // so a caller may stop between any two tokens and resume later. A token received with no
+        // open frame starts a new root value.
+        template <typename Handler>
+        step_t step_(const json_token& token, Handler& handler) {
+            if (frames_.empty()) {
+                switch (token.type) {
+                    case json_token_type::end_of_file:
+                        return stop_(json_errc::empty_document, token.offset);
+                    case json_token_type::invalid:
+                        return stop_(token.error, token.offset);
+                    case json_token_type::left_brace:
+                    case json_token_type::left_bracket:
+                        if (frames_.capacity() == 0) {
+                            frames_.reserve(32);
                         }
-                        default:
-                            return { json_token_type::invalid, json_value(nullptr),
-                                     false, "Invalid escape sequence: \\" + std::string(1, esc) };
+                        return open_(handler, token.type == json_token_type::left_brace, token.offset);
+                    default:
+                        if (!is_value_token(token.type)) {
+                            return stop_(json_errc::unexpected_root_token, token.offset);
+                        }
+                        if (!emit_value_(handler, token)) {
+                            return stop_(json_errc::handler_aborted, token.offset);
+                        }
+                        return step_t::done;
+                }
+            }
+
+            bool in_object{ frames_.back().is_object };
+
+            switch (token.type) {
+                case json_token_type::left_brace:
+                case json_token_type::left_bracket: {
+                    bool is_object{ token.type == json_token_type::left_brace };
+                    if (expect_ != expect_t::value && (in_object || expect_ != expect_t::first_value)) {
+                        return stop_(is_object ? json_errc::unexpected_left_brace : json_errc::unexpected_left_bracket, token.offset);
                     }
-                    advance_();
+                    return open_(handler, is_object, token.offset);
                 }
-                else {
-                    if (static_cast<unsigned char>(ch) < 0x20) {
-                        return { json_token_type::invalid, json_value(nullptr),
-                                 false, "Control character in string: " + std::string(1, ch) };
+                case json_token_type::right_brace:
+                    if (!in_object) {
+                        return stop_(json_errc::unexpected_right_brace, token.offset);
                     }
-                    result += ch;
-                    advance_();
+                    if (expect_ == expect_t::key) {
+                        return stop_(json_errc::dangling_comma_in_object, token.offset);
+                    }
+                    if (expect_ == expect_t::colon) {
+                        return stop_(json_errc::expected_colon, token.offset);
+                    }
+                    if (expect_ == expect_t::value) {
+                        return stop_(json_errc::expected_value, token.offset);
+                    }
+                    return close_(handler, true, token.offset);
+                case json_token_type::right_bracket:
+                    if (in_object) {
+                        return stop_(json_errc::unexpected_right_bracket, token.offset);
+                    }
+                    if (expect_ == expect_t::value) {
+                        return stop_(json_errc::dangling_comma_in_array, token.offset);
+                    }
+                    return close_(handler, false, token.offset);
+                case json_token_type::comma:
+                    if (expect_ != expect_t::comma_or_end) {
+                        return stop_(json_errc::unexpected_comma, token.offset);
+                    }
+                    expect_ = in_object ? expect_t::key : expect_t::value;
+                    return step_t::more;
+                case json_token_type::colon:
+                    if (expect_ != expect_t::colon) {
+                        return stop_(json_errc::unexpected_colon, token.offset);
+                    }
+                    expect_ = expect_t::value;
+                    return step_t::more;
+                case json_token_type::end_of_file:
+                    return stop_(json_errc::unexpected_end_of_file, token.offset);
+                case json_token_type::invalid:
+                    return stop_(token.error, token.offset);
+                default: // value tokens
+                    if (expect_ == expect_t::first_key || expect_ == expect_t::key) {
+                        if (token.type != json_token_type::string_value) {
+                            return stop_(json_errc::expected_string_key, token.offset);
+                        }
+                        if (token.length == 0) {
+                            return stop_(json_errc::empty_key, token.offset);
+                        }
+                        if (!handler.on_key(token.string_value())) {
+                            return stop_(json_errc::handler_aborted, token.offset);
+                        }
+                        expect_ = expect_t::colon;
+                    }
+                    else if (expect_ == expect_t::value || (expect_ == expect_t::first_value && !in_object)) {
+                        if (!emit_value_(handler, token)) {
+                            return stop_(json_errc::handler_aborted, token.offset);
+                        }
+                        expect_ = expect_t::comma_or_end;
+                    }
+                    else {
+                        return stop_(json_errc::unexpected_value, token.offset);
+                    }
+                    return step_t::more;
+            }
+        }
+
+        // Whether token may be cut short by the end of a buffer that is not the end of the input:
+        // a number reaching the end, or a lexing error close enough to it to stem from a
+        // truncated literal, escape or surrogate pair
+        static bool may_continue_(const json_token& token, std::size_t size) noexcept {
+            if (token.type == json_token_type::invalid) {
+                return token.offset + 6 >= size;
+            }
+            if (token.type == json_token_type::int_value || token.type == json_token_type::double_value) {
+                return token.offset + token.length == size;
+            }
+            return false;
+        }
+
+        // Runs the grammar over buffer, the unconsumed part of a document delivered in pieces that
+        // starts at byte base of the input. Unless last is set, stops before a token that may
+        // continue in the next piece and sets consumed to the length of buffer already parsed.
+        bool push_(std::string_view buffer, std::size_t base, bool last, std::size_t& consumed, json_value& root) {
+            lexer_.reset(buffer);
+            base_offset_ = base;
+            consumed = 0;
+            while (is_valid_) {
+                json_token token = lexer_.next_token();
+                if (!last && (token.type == json_token_type::end_of_file || may_continue_(token, buffer.size()))) {
+                    consumed = lexer_.token_start();
+                    return true;
+                }
+                if (done_) {
+                    return token.type == json_token_type::end_of_file || fail_(json_errc::trailing_content, token.offset);
+                }
+                step_t step{ step_(token, builder_) };
+                if (step == step_t::failed) {
+                    return false;
+                }
+                if (step == step_t::done) {
+                    done_ = true;
+                    root = builder_.take_root();
+                    if (last) {
+                        return expect_end_();
+                    }
+                }
+            }
+            return false;
+        }
+
+        // Reports one value to handler. Containers are driven by an explicit frame stack, so the
+        // parse does not recurse however deep the document is.
+        template <typename Handler>
+        bool parse_value_(Handler& handler, json_token token) {
+            frames_.clear();
+            while (true) {
+                step_t step{ step_(token, handler) };
+                if (step != step_t::more) {
+                    return step == step_t::done;
+                }
+                token = next_token_();
+            }
+        }
+
+    private:
+
+        struct frame_t {
+            bool is_object{ false };
+        };
+
+    private:
+
+        json_lexer lexer_;
+        json_parse_options options_;
+        json_dom_builder builder_;
+        json_structural_index own_index_{};
+        const std::uint32_t* cursor_{ nullptr };
+        const std::uint32_t* cursor_end_{ nullptr };
+        std::vector<frame_t> frames_{};
+        expect_t expect_{ expect_t::first_value };
+        std::size_t base_offset_{ 0 };
+        std::size_t consumed_{ 0 };
+        bool done_{ false };
+        bool is_valid_{ true };
+        json_error error_{};
+        mutable std::string error_message_{};
+
+    }; // class json_parser
+
+    // Incremental parser for a document that arrives in pieces. Each feed() parses every token
+    // that is complete so far and keeps only the unfinished tail, so a string, number or \u
+    // escape may be split anywhere between chunks; finish() ends the input and returns the
+    // document. Errors report offsets into the whole input.
+    class json_push_parser {
+    public:
+
+        json_push_parser(const json_push_parser&) = delete;
+        json_push_parser(json_push_parser&&) = delete;
+        json_push_parser& operator=(const json_push_parser&) = delete;
+        json_push_parser& operator=(json_push_parser&&) = delete;
+
+    public:
+
+        explicit json_push_parser(const json_parse_options& options = {}) :
+            parser_{ std::string_view{}, single_stage_(options) }
+        {
+        }
+
+    public:
+
+        // Returns false once the input is known to be invalid
+        bool feed(std::string_view chunk) {
+            if (!parser_.is_valid()) {
+                return false;
+            }
+            // A pending string cannot end before the next quote, so chunks without one are only
+            // buffered rather than lexing the string again from its start
+            if (in_string_ && chunk.find('"') == std::string_view::npos) {
+                buffer_.append(chunk);
+                return true;
+            }
+            compact_();
+            buffer_.append(chunk);
+            return run_(false);
+        }
+
+        // The parsed document, or null when the input is invalid or incomplete
+        [[nodiscard]] json_value finish() {
+            compact_();
+            if (!parser_.is_valid() || !run_(true)) {
+                return json_value(nullptr);
+            }
+            return std::move(root_);
+        }
+
+        bool is_valid() const {
+            return parser_.is_valid();
+        }
+
+        const json_error& error() const {
+            return parser_.error();
+        }
+
+        const std::string& error_message() const {
+            return parser_.error_message();
+        }
+
+    private:
+
+        // Chunks are lexed as they arrive, there is no whole source to index
+        static json_parse_options single_stage_(json_parse_options options) noexcept {
+            options.two_stage = false;
+            return options;
+        }
+
+        void compact_() {
+            buffer_.erase(0, consumed_);
+            base_ += consumed_;
+            consumed_ = 0;
+        }
+
+        bool run_(bool last) {
+            bool ok{ parser_.push_(buffer_, base_, last, consumed_, root_) };
+            in_string_ = consumed_ < buffer_.size() && buffer_[consumed_] == '"';
+            return ok;
+        }
+
+    private:
+
+        json_parser parser_;
+        std::string buffer_{};
+        std::size_t base_{ 0 };
+        std::size_t consumed_{ 0 };
+        bool in_string_{ false };
+        json_value root_{};
+
+    }; // class json_push_parser
+
+    namespace detail {
+
+        // Returns the position after the string that opens at pos. The source must be valid.
+        inline std::size_t skip_string(std::string_view source, std::size_t pos) noexcept {
+            const char* begin{ source.data() };
+            const char* end{ begin + source.size() };
+            const char* it{ begin + pos + 1 };
+            while (true) {
+                it = find_string_special(it, end);
+                if (it == end) {
+                    return source.size();
+                }
+                if (*it == '"') {
+                    return static_cast<std::size_t>(it - begin) + 1;
+                }
+                it += *it == '\\' ? 2 : 1;
+            }
+        }
+
+        // Returns the position after the value that starts at pos, stepping over nested
+        // containers by bracket depth alone. With the structural index of the source, containers
+        // are skipped over its offsets and the bytes of strings and numbers are never read.
+        // The source must be valid.
+        inline std::size_t skip_value(std::string_view source, std::size_t pos,
+            std::span<const std::uint32_t> index = {}) noexcept {
+            char ch{ source[pos] };
+            if (!index.empty() && (ch == '{' || ch == '[')) {
+                std::size_t depth{ 0 };
+                for (auto it = std::lower_bound(index.begin(), index.end(), pos); it != index.end(); ++it) {
+                    ch = source[*it];
+                    if (ch == '{' || ch == '[') {
+                        ++depth;
+                    }
+                    else if ((ch == '}' || ch == ']') && --depth == 0) {
+                        return *it + std::size_t{ 1 };
+                    }
+                }
+                return source.size();
+            }
+            if (ch == '"') {
+                return skip_string(source, pos);
+            }
+            if (ch != '{' && ch != '[') {
+                while (pos < source.size() && !is_scalar_end(source[pos])) {
+                    ++pos;
+                }
+                return pos;
+            }
+            std::size_t depth{ 0 };
+            while (pos < source.size()) {
+                ch = source[pos];
+                if (ch == '"') {
+                    pos = skip_string(source, pos);
+                    continue;
+                }
+                if (ch == '{' || ch == '[') {
+                    ++depth;
+                }
+                else if ((ch == '}' || ch == ']') && --depth == 0) {
+                    return pos + 1;
+                }
+                ++pos;
+            }
+            return pos;
+        }
+
+        inline std::size_t skip_whitespace_from(std::string_view source, std::size_t pos) noexcept {
+            const char* begin{ source.data() };
+            return static_cast<std::size_t>(skip_whitespace(begin + pos, begin + source.size()) - begin);
+        }
+
+        // Position of the value after the separator that follows the value ending at pos, or
+        // npos when the enclosing container closes there
+        inline std::size_t next_element(std::string_view source, std::size_t pos) noexcept {
+            pos = skip_whitespace_from(source, pos);
+            if (pos >= source.size() || source[pos] != ',') {
+                return std::string_view::npos;
+            }
+            return skip_whitespace_from(source, pos + 1);
+        }
+
+        // Position of the first child of the container that opens at pos, or npos when it is empty
+        inline std::size_t first_element(std::string_view source, std::size_t pos) noexcept {
+            pos = skip_whitespace_from(source, pos + 1);
+            return pos < source.size() && (source[pos] == ']' || source[pos] == '}') ? std::string_view::npos : pos;
+        }
+
+    } // namespace detail
+
+    class json_ondemand_value;
+
+    // Object member read in place: the key is the raw text between the quotes
+    class json_ondemand_member {
+    public:
+
+        std::string_view raw_key() const noexcept;
+
+        // Unescaped key; refers to the source unless the key has escapes, then to scratch
+        std::string_view key(std::string& scratch) const;
+
+        json_ondemand_value value() const noexcept;
+
+    private:
+
+        friend class json_ondemand_value;
+
+        json_ondemand_member(std::string_view source, std::span<const std::uint32_t> index, std::size_t key_offset) noexcept :
+            source_{ source },
+            index_{ index },
+            key_offset_{ key_offset }
+        {
+        }
+
+    private:
+
+        std::string_view source_;
+        std::span<const std::uint32_t> index_;
+        std::size_t key_offset_;
+
+    }; // class json_ondemand_member
+
+    // Handle to one value of a validated json_ondemand_document: a position in the source. Scalars
+    // are decoded on request and containers are walked in place; subtrees that are not visited
+    // are skipped without being decoded. Valid as long as the source buffer.
+    class json_ondemand_value {
+    public:
+
+        // Forward iteration over array elements or object members
+        template <typename T>
+        class iterator_t {
+        public:
+
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+        public:
+
+            iterator_t() = default;
+
+            T operator*() const noexcept {
+                return T(source_, index_, pos_);
+            }
+
+            iterator_t& operator++() noexcept {
+                std::size_t value{ pos_ };
+                if constexpr (std::is_same_v<T, json_ondemand_member>) {
+                    value = (**this).value().offset_;
+                }
+                pos_ = detail::next_element(source_, detail::skip_value(source_, value, index_));
+                return *this;
+            }
+
+            iterator_t operator++(int) noexcept {
+                iterator_t tmp{ *this };
+                ++*this;
+                return tmp;
+            }
+
+            friend bool operator==(const iterator_t& lhs, const iterator_t& rhs) noexcept {
+                return lhs.pos_ == rhs.pos_;
+            }
+
+        private:
+
+            friend class json_ondemand_value;
+
+            iterator_t(std::string_view source, std::span<const std::uint32_t> index, std::size_t pos) noexcept :
+                source_{ source },
+                index_{ index },
+                pos_{ pos }
+            {
+            }
+
+        private:
+
+            std::string_view source_{};
+            std::span<const std::uint32_t> index_{};
+            std::size_t pos_{ std::string_view::npos };
+        };
+
+        template <typename T>
+        class range_t {
+        public:
+
+            iterator_t<T> begin() const noexcept {
+                return first_;
+            }
+
+            iterator_t<T> end() const noexcept {
+                return {};
+            }
+
+        private:
+
+            friend class json_ondemand_value;
+
+            explicit range_t(iterator_t<T> first) noexcept :
+                first_{ first }
+            {
+            }
+
+        private:
+
+            iterator_t<T> first_;
+        };
+
+        using element_iterator = iterator_t<json_ondemand_value>;
+        using member_iterator = iterator_t<json_ondemand_member>;
+
+    public:
+
+        json_ondemand_value() noexcept = default;
+
+    public:
+
+        [[nodiscard]] json_type type() const noexcept {
+            switch (first_char_()) {
+                case '{': return json_type::object;
+                case '[': return json_type::array;
+                case '"': return json_type::string;
+                case 't':
+                case 'f': return json_type::boolean;
+                case 'n': return json_type::null;
+                default: break;
+            }
+            for (std::size_t pos = offset_; pos < source_.size() && !detail::is_scalar_end(source_[pos]); ++pos) {
+                if (source_[pos] == '.' || source_[pos] == 'e' || source_[pos] == 'E') {
+                    return json_type::floating;
                 }
             }
+            return json_type::integer;
+        }
+
+        [[nodiscard]] bool is_null() const noexcept {
+            return first_char_() == 'n';
+        }
+
+        // Scalar accessors throw std::bad_variant_access on a type mismatch, as json_value::as does
+        [[nodiscard]] json_bool_t get_bool() const {
+            json_lexer lexer(tail_());
+            return token_of_(lexer, json_token_type::bool_value).bool_value;
+        }
+
+        [[nodiscard]] json_int_t get_int() const {
+            json_lexer lexer(tail_());
+            return token_of_(lexer, json_token_type::int_value).int_value;
+        }
+
+        // Integers are converted
+        [[nodiscard]] json_double_t get_double() const {
+            json_lexer lexer(tail_());
+            json_token token{ lexer.next_token() };
+            if (token.type == json_token_type::int_value) {
+                return static_cast<json_double_t>(token.int_value);
+            }
+            if (token.type != json_token_type::double_value) {
+                throw std::bad_variant_access{};
+            }
+            return token.double_value;
+        }
 
-            return { json_token_type::invalid, json_value(nullptr),
-                     false, "Unterminated string" };
+        // Refers to the source unless the string has escapes, then to scratch
+        [[nodiscard]] std::string_view get_string(std::string& scratch) const {
+            json_lexer lexer(tail_());
+            json_token token{ token_of_(lexer, json_token_type::string_value) };
+            std::string_view value{ token.string_value() };
+            if (value.data() >= source_.data() && value.data() < source_.data() + source_.size()) {
+                return value;
+            }
+            scratch.assign(value);
+            return scratch;
         }
 
-        inline bool encode_utf8_(std::uint32_t codepoint, std::string& out) {
-            if (codepoint <= 0x7F) {
-                out += static_cast<char>(codepoint);
-                return true;
+        // Source text of the value, containers included
+        [[nodiscard]] std::string_view raw_json() const noexcept {
+            return source_.substr(offset_, detail::skip_value(source_, offset_, index_) - offset_);
+        }
+
+        // Builds a json_value tree of this value only
+        [[nodiscard]] json_value to_value(const json_parse_options& options = {}) const {
+            json_parser parser(raw_json(), options);
+            return parser.parse();
+        }
+
+        [[nodiscard]] range_t<json_ondemand_value> elements() const {
+            return range_t<json_ondemand_value>(element_iterator(source_, index_, first_child_(json_type::array)));
+        }
+
+        [[nodiscard]] range_t<json_ondemand_member> members() const {
+            return range_t<json_ondemand_member>(member_iterator(source_, index_, first_child_(json_type::object)));
+        }
+
+        // Number of elements or members, found by skipping over each of them
+        [[nodiscard]] std::size_t size() const {
+            std::size_t count{ 0 };
+            if (first_char_() == '{') {
+                for (auto it = members().begin(); it != member_iterator{}; ++it) {
+                    ++count;
+                }
             }
-            if (codepoint <= 0x7FF) {
-                out += static_cast<char>(0xC0 | (codepoint >> 6));
-                out += static_cast<char>(0x80 | (codepoint & 0x3F));
-                return true;
+            else {
+                for (auto it = elements().begin(); it != element_iterator{}; ++it) {
+                    ++count;
+                }
             }
-            if (codepoint <= 0xFFFF) {
-                out += static_cast<char>(0xE0 | (codepoint >> 12));
-                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                out += static_cast<char>(0x80 | (codepoint & 0x3F));
-                return true;
+            return count;
+        }
+
+        // First member named key; the search stops there, later members are never scanned
+        [[nodiscard]] std::optional<json_ondemand_value> find(std::string_view key) const {
+            std::string scratch;
+            for (json_ondemand_member member : members()) {
+                std::string_view raw{ member.raw_key() };
+                bool escaped{ raw.find('\\') != std::string_view::npos };
+                if (escaped ? member.key(scratch) == key : raw == key) {
+                    return member.value();
+                }
             }
-            if (codepoint <= 0x10FFFF) {
-                out += static_cast<char>(0xF0 | (codepoint >> 18));
-                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
-                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                out += static_cast<char>(0x80 | (codepoint & 0x3F));
-                return true;
+            return std::nullopt;
+        }
+
+        [[nodiscard]] json_ondemand_value at(std::string_view key) const {
+            std::optional<json_ondemand_value> value{ find(key) };
+            if (!value) {
+                throw std::out_of_range("json_ondemand_value::at: key not found");
             }
-            return false;
+            return *value;
         }
 
-        inline bool starts_with_(const std::string& value) const {
-            std::size_t size{ source_.size() };
-            if (pos_ + value.size() > size) {
-                return false;
+        [[nodiscard]] json_ondemand_value at(std::size_t index) const {
+            for (json_ondemand_value value : elements()) {
+                if (index-- == 0) {
+                    return value;
+                }
             }
-            return source_.compare(pos_, value.size(), value) == 0;
+            throw std::out_of_range("json_ondemand_value::at: index out of range");
         }
 
-        void advance_(std::size_t count = 1) noexcept {
-            pos_ += count;
+        [[nodiscard]] json_ondemand_value operator[](std::string_view key) const {
+            return at(key);
         }
 
-        std::string::value_type peek_() const {
-            assert(pos_ < source_.size());
-            return source_[pos_];
+        [[nodiscard]] json_ondemand_value operator[](std::size_t index) const {
+            return at(index);
         }
 
-        void skip_whitespaces_() {
-            std::size_t size{ source_.size() };
-            while (pos_ < size && std::isspace(static_cast<unsigned char>(source_[pos_]))) {
-                pos_++;
+    private:
+
+        friend class json_ondemand_document;
+        friend class json_ondemand_member;
+
+        json_ondemand_value(std::string_view source, std::span<const std::uint32_t> index, std::size_t offset) noexcept :
+            source_{ source },
+            index_{ index },
+            offset_{ offset }
+        {
+        }
+
+        char first_char_() const noexcept {
+            return offset_ < source_.size() ? source_[offset_] : '\0';
+        }
+
+        std::string_view tail_() const noexcept {
+            return source_.substr(std::min(offset_, source_.size()));
+        }
+
+        static json_token token_of_(json_lexer& lexer, json_token_type type) {
+            json_token token{ lexer.next_token() };
+            if (token.type != type) {
+                throw std::bad_variant_access{};
+            }
+            return token;
+        }
+
+        std::size_t first_child_(json_type type) const {
+            if (this->type() != type) {
+                throw std::bad_variant_access{};
             }
+            return detail::first_element(source_, offset_);
         }
 
     private:
 
-        std::size_t pos_;
-        const std::string& source_;
+        std::string_view source_{ "null" };
+        std::span<const std::uint32_t> index_{};
+        std::size_t offset_{ 0 };
 
-    }; // class json_lexer
+    }; // class json_ondemand_value
 
-    class json_parser {
-    public:
+    inline std::string_view json_ondemand_member::raw_key() const noexcept {
+        std::size_t end{ detail::skip_string(source_, key_offset_) };
+        return source_.substr(key_offset_ + 1, end - key_offset_ - 2);
+    }
 
-        json_parser() = delete;
-        json_parser(const json_parser&) = delete;
-        json_parser(json_parser&&) = delete;
-        json_parser& operator=(const json_parser&) = delete;
-        json_parser& operator=(json_parser&&) = delete;
+    inline std::string_view json_ondemand_member::key(std::string& scratch) const {
+        return json_ondemand_value(source_, index_, key_offset_).get_string(scratch);
+    }
 
+    inline json_ondemand_value json_ondemand_member::value() const noexcept {
+        std::size_t pos{ detail::skip_whitespace_from(source_, detail::skip_string(source_, key_offset_)) };
+        return json_ondemand_value(source_, index_, detail::skip_whitespace_from(source_, pos + 1));
+    }
+
+    // On-demand view of a document: the source is validated once, without building a tree, and
+    // values are then read directly from it through json_ondemand_value handles. The source
+    // buffer is not copied and must outlive the document and every handle taken from it.
+    // With json_parse_options::two_stage the document keeps its structural index, validates
+    // over it and lets handles skip containers through it.
+    class json_ondemand_document {
     public:
 
-        explicit json_parser(const std::string& src_str) :
-            lexer_{ src_str }
+        explicit json_ondemand_document(std::string_view source, const json_parse_options& options = {}) :
+            source_{ source }
         {
+            validate_(options);
+        }
+
+    public:
 
+        // The null value when the document is not valid
+        [[nodiscard]] json_ondemand_value root() const noexcept {
+            if (!is_valid_) {
+                return {};
+            }
+            return json_ondemand_value(source_, index_.offsets(), detail::skip_whitespace_from(source_, 0));
         }
 
-        [[nodiscard]] json_value parse() {
+        std::string_view source() const noexcept {
+            return source_;
+        }
 
-            json_value root;
+        bool is_valid() const {
+            return is_valid_;
+        }
 
-            std::stack<json_value> stack;
-            json_token token = lexer_.next_token();
+        const json_error& error() const {
+            return error_;
+        }
 
-            if (token.type == json_token_type::end_of_file) {
-                log_error_("Empty JSON document");
-                return root;
-            }
-            else if (!token.is_valid || token.type == json_token_type::invalid) {
-                log_error_(token.error_str);
-                return root;
-            }
-            else if (is_value_token(token.type)) {
-                root = std::move(token.value);
-            }
-            else if (token.type == json_token_type::left_brace) {
-                stack.push(json_value(json_object{}));
-                root = parse_complex_(stack);
+        const std::string& error_message() const {
+            if (error_message_.empty() && error_) {
+                error_message_ = error_.message();
             }
-            else if (token.type == json_token_type::left_bracket) {
-                stack.push(json_value(json_array{}));
-                root = parse_complex_(stack);
+            return error_message_;
+        }
+
+    private:
+
+        void validate_(const json_parse_options& options) {
+            if (options.two_stage && index_.build(source_)) {
+                json_parser parser(source_, index_, options);
+                is_valid_ = parser.validate();
+                error_ = parser.error();
             }
             else {
-                log_error_("Unexpected token in root: " + token.error_str);
-                return root;
+                json_parser parser(source_, options);
+                is_valid_ = parser.validate();
+                error_ = parser.error();
             }
+        }
 
-            if (lexer_.next_token().type != json_token_type::end_of_file) {
-                log_error_("Unexpected tokens after JSON document end");
-                return json_value(nullptr);
-            }
+    private:
 
-            return root;
+        std::string_view source_;
+        json_structural_index index_{};
+        bool is_valid_{ false };
+        json_error error_{};
+        mutable std::string error_message_{};
+
+    }; // class json_ondemand_document
+
+
+    struct json_serialize_options {
+        // Newlines and indentation between members; false selects the minified fast path
+        bool pretty{ true };
+        std::size_t indent_size{ 4 };
+        // Writes object members in byte order of their names instead of insertion order
+        bool sort_keys{ false };
+    };
+
+    // Destination of serialized output. Either appends to a caller-owned string, which can be
+    // reused across documents to keep its capacity, or stages output in a chunk that is passed to
+    // a sink whenever it reaches chunk_size and on flush().
+    class json_writer {
+    public:
+
+        using sink_type = std::function<void(std::string_view)>;
+
+    public:
+
+        json_writer(const json_writer&) = delete;
+        json_writer(json_writer&&) = delete;
+        json_writer& operator=(const json_writer&) = delete;
+        json_writer& operator=(json_writer&&) = delete;
+
+    public:
+
+        explicit json_writer(std::string& buffer) :
+            buffer_{ &buffer }
+        {
         }
 
-        bool is_valid() const {
-            return is_valid_;
+        explicit json_writer(sink_type sink, std::size_t chunk_size = 16384) :
+            buffer_{ &chunk_ },
+            sink_{ std::move(sink) },
+            chunk_size_{ chunk_size }
+        {
+            chunk_.reserve(chunk_size);
         }
 
-        const std::string& error_message() const {
-            return error_message_;
+    public:
+
+        void put(char c) {
+            buffer_->push_back(c);
+            commit_();
         }
 
+        void write(std::string_view text) {
+            buffer_->append(text);
+            commit_();
+        }
 
-    private:
+        void fill(char c, std::size_t count) {
+            buffer_->append(count, c);
+            commit_();
+        }
 
-        void log_error_(const std::string& text) {
-            is_valid_ = false;
-            if (!error_message_.empty()) {
-                error_message_ += '\n';
+        // Hands staged output to the sink; a no-op when writing to a string
+        void flush() {
+            if (sink_ && !chunk_.empty()) {
+                sink_(std::string_view(chunk_));
+                chunk_.clear();
             }
-            error_message_ += text;
         }
 
-        json_value parse_complex_(std::stack<json_value>& stack) {
-            std::stack<std::string> key_stack;
-            enum class context_t { object, array } context{
-                stack.top().is<json_object>() ? context_t::object : context_t::array
-            };
-            enum class token_expected_t {
-                value, key, comma, colon
-            } token_expected{
-                context == context_t::array ? token_expected_t::value : token_expected_t::key
-            };
-            bool dangling_comma{ false };
+    private:
 
-            while (true) {
-                json_token token = lexer_.next_token();
-                if (token.type == json_token_type::left_brace) { // {
-                    if (token_expected == token_expected_t::value) {
-                        stack.push(json_value(json_object{}));
-                        context = context_t::object;
-                        token_expected = token_expected_t::key;
-                        dangling_comma = false;
-                    }
-                    else {
-                        log_error_("Unexpected left brace in array or object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::right_brace) { // }
-                    if (dangling_comma && token_expected == token_expected_t::key) {
-                        log_error_("Dangling comma before right brace in object context");
-                        return json_value(nullptr);
-                    }
-                    if (context == context_t::object) {
-                        json_value complete_node;
-                        complete_node = std::move(stack.top());
-                        stack.pop();
-                        if (stack.empty()) {
-                            return json_value(std::move(complete_node));
-                        }
-                        else {
-                            dangling_comma = false;
-                            context = stack.top().is<json_object>() ? context_t::object : context_t::array;
-                            if (context == context_t::array) {
-                                stack.top().as<json_array>().emplace_back(std::move(complete_node));
-                            }
-                            else {
-                                stack.top().as<json_object>().emplace(std::move(key_stack.top()), std::move(complete_node));
-                                key_stack.pop();
-                            }
-                            token_expected = token_expected_t::comma;
-                        }
-                    }
-                    else { // context == context_t::array
-                        log_error_("Unexpected right brace in array context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::left_bracket) { // [
-                    if (token_expected == token_expected_t::value) {
-                        stack.push(json_value(json_array{}));
-                        context = context_t::array;
-                        //token_expected = token_expected_t::value;
-                        dangling_comma = false;
-                    }
-                    else {
-                        log_error_("Unexpected left bracket in array or object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::right_bracket) { // ]
-                    if (dangling_comma && token_expected == token_expected_t::value) {
-                        log_error_("Dangling comma before right bracket in array context");
-                        return json_value(nullptr);
-                    }
-                    if (context == context_t::array) {
-                        json_value complete_node;
-                        complete_node = std::move(stack.top());
-                        stack.pop();
-                        if (stack.empty()) {
-                            return json_value(std::move(complete_node));
-                        }
-                        else {
-                            context = stack.top().is<json_object>() ? context_t::object : context_t::array;
-                            if (context == context_t::array) {
-                                stack.top().as<json_array>().emplace_back(std::move(complete_node));
-                            }
-                            else {
-                                stack.top().as<json_object>().emplace(std::move(key_stack.top()), std::move(complete_node));
-                                key_stack.pop();
-                            }
-                            token_expected = token_expected_t::comma;
-                        }
-                    }
-                    else {
-                        log_error_("Unexpected right bracket in object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::end_of_file) {
-                    log_error_("Unexpected end of file in array or object context");
-                    return json_value(nullptr);
-                }
-                else if (token.type == json_token_type::invalid) {
-                    log_error_(token.error_str);
-                    return json_value(nullptr);
-                }
-                else if (is_value_token(token.type)) {
-                    if (token_expected == token_expected_t::key && context == context_t::object) {
-                        if (!token.value.is<json_string_t>()) {
-                            log_error_("Expected string key in object context");
-                            return json_value(nullptr);
-                        }
-                        key_stack.emplace(std::move(token.value.as<json_string_t>()));
-                        if (key_stack.top().empty()) {
-                            log_error_("Empty key in object context");
-                            return json_value(nullptr);
-                        }
-                        token_expected = token_expected_t::colon;
-                    }
-                    else if (token_expected == token_expected_t::value) {
-                        if (context == context_t::object) {
-                            stack.top().as<json_object>()[key_stack.top()] = std::move(token.value);
-                            key_stack.pop();
-                        }
-                        else { // context == context_t::array
-                            stack.top().as<json_array>().emplace_back(std::move(token.value));
-                        }
-                        token_expected = token_expected_t::comma;
-                    }
-                    else {
-                        log_error_("Unexpected value in array or object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::comma) {
-                    if (token_expected == token_expected_t::comma) {
-                        token_expected = context == context_t::array ? token_expected_t::value : token_expected_t::key;
-                        dangling_comma = true;
-                        continue;
-                    }
-                    else {
-                        log_error_("Unexpected comma in array or object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else if (token.type == json_token_type::colon) {
-                    if (token_expected == token_expected_t::colon && context == context_t::object) {
-                        token_expected = token_expected_t::value;
-                        continue;
-                    }
-                    else {
-                        log_error_("Unexpected colon in array or object context");
-                        return json_value(nullptr);
-                    }
-                }
-                else {
-                    log_error_("Unexpected token in array: " + token.error_str);
-                    return json_value(nullptr);
-                }
+        void commit_() {
+            if (sink_ && chunk_.size() >= chunk_size_) {
+                flush();
             }
         }
 
     private:
 
-        json_lexer lexer_;
-        bool is_valid_{ true };
-        std::string error_message_{};
+        std::string* buffer_;
+        std::string chunk_{};
+        sink_type sink_{};
+        std::size_t chunk_size_{ 0 };
 
-    }; // class json_parser
+    }; // class json_writer
 
+    namespace detail {
+        // Lets json_file.h report a file that cannot be read on the returned json_document
+        struct file_access;
+    }
 
     class json_document {
     public:
@@ -741,7 +3076,7 @@ namespace json {
         {
         }
 
-        explicit json_document(const std::string& str) {
+        explicit json_document(std::string_view str) {
             from_string(str);
         }
 
@@ -777,207 +3112,255 @@ namespace json {
             return is_valid_;
         }
 
+        const json_error& error() const {
+            return error_;
+        }
+
         const std::string& error_message() const {
+            if (error_message_.empty() && error_) {
+                error_message_ = error_.message();
+            }
             return error_message_;
         }
 
     public:
 
-        std::string to_string() const {
-            return (root_.is<json_array>() || root_.is<json_object>()) ?
-                format_complex_node_(root_) :
-                format_simple_node_(root_);
+        std::string to_string(const json_serialize_options& options = {}) const {
+            std::string result;
+            to_string(result, options);
+            return result;
+        }
+
+        // Replaces the contents of buffer, keeping its capacity for the next document
+        void to_string(std::string& buffer, const json_serialize_options& options = {}) const {
+            buffer.clear();
+            json_writer writer(buffer);
+            write(writer, options);
+        }
+
+        // Appends to writer without flushing it
+        void write(json_writer& writer, const json_serialize_options& options = {}) const {
+            if (!root_.is<json_array>() && !root_.is<json_object>()) {
+                format_simple_node_(root_, writer);
+            }
+            else if (options.pretty) {
+                format_complex_node_<true>(root_, options, writer);
+            }
+            else {
+                format_complex_node_<false>(root_, options, writer);
+            }
         }
 
-        void from_string(const std::string& str) {
-            json_parser parser(str);
+        void from_string(std::string_view str, const json_parse_options& options = {}) {
+            json_parser parser(str, options);
             json_value parsed = parser.parse();
             if (parser.is_valid()) {
                 root_ = std::move(parsed);
                 is_valid_ = true;
-                error_message_.clear();
+                error_ = {};
             }
             else {
                 is_valid_ = false;
-                error_message_ = parser.error_message();
+                error_ = parser.error();
             }
+            error_message_.clear();
         }
 
     private:
 
-        std::string format_string_(const json_string_t& value) const {
-            std::string result;
-            result.reserve(value.size() + 2);
-            result += '"';
-            for (char c : value) {
-                switch (c) {
-                    case '\"': result += "\\\""; break;
-                    case '\\': result += "\\\\"; break;
-                    case '\b': result += "\\b"; break;
-                    case '\f': result += "\\f"; break;
-                    case '\n': result += "\\n"; break;
-                    case '\r': result += "\\r"; break;
-                    case '\t': result += "\\t"; break;
-                    default:
-                        if (static_cast<unsigned char>(c) < 0x20) {
-                            result += "\\u" + std::format("{:04x}", static_cast<unsigned char>(c));
-                        }
-                        else {
-                            result += c;
-                        }
+        friend struct detail::file_access;
+
+        // Copies runs that need no escaping in bulk; the scan stops only at bytes the escape
+        // table maps to a sequence
+        void format_string_(std::string_view value, json_writer& out) const {
+            static constexpr char hex_digits[]{ "0123456789abcdef" };
+            const char* first{ value.data() };
+            const char* last{ first + value.size() };
+            out.put('"');
+            while (first != last) {
+                const char* special{ detail::find_string_special(first, last) };
+                out.write({ first, static_cast<std::size_t>(special - first) });
+                if (special == last) {
+                    break;
+                }
+                unsigned char c{ static_cast<unsigned char>(*special) };
+                char escape{ detail::escape_table[c] };
+                if (escape == 'u') {
+                    char unicode[]{ '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf] };
+                    out.write({ unicode, sizeof(unicode) });
+                }
+                else {
+                    char sequence[]{ '\\', escape };
+                    out.write({ sequence, sizeof(sequence) });
                 }
+                first = special + 1;
             }
-            result += '"';
-            return result;
+            out.put('"');
         }
 
-        std::string format_complex_node_(const json_value& value) const {
-            struct stack_frame {
-                const json_value* ptr{ nullptr };
-                std::size_t index{ 0 };
-                std::size_t size{ 0 };
-                std::vector<std::string> keys{};
-            };
+        using member_order_t = std::vector<const json_object::value_type*>;
 
-            int indent_level = 0;
-            constexpr int indent_size = 4;
-            std::ostringstream oss;
-            std::stack<stack_frame> stack;
+        struct format_frame_t {
+            const json_value* ptr{ nullptr };
+            std::size_t index{ 0 };
+            std::size_t size{ 0 };
+            std::size_t order{ 0 };     // first entry on the member order when sorting keys
+        };
 
-            stack.push({ &value });
+        // Pushes obj's members sorted by name onto order; the caller pops them with the frame
+        static void sort_members_(const json_object& obj, member_order_t& order) {
+            std::size_t first{ order.size() };
+            for (const auto& member : obj) {
+                order.push_back(&member);
+            }
+            std::sort(order.begin() + static_cast<std::ptrdiff_t>(first), order.end(),
+                [](const json_object::value_type* lhs, const json_object::value_type* rhs) {
+                    return lhs->first.view() < rhs->first.view();
+                });
+        }
 
-            auto check_comma = [&]() {
-                if (!stack.empty()) {
-                    const auto& top_frame = stack.top();
-                    if (top_frame.index < top_frame.size) {
-                        oss << ",\n";
+        // Single pass over the tree with an explicit stack of container positions. Members are read
+        // in place, so nothing is copied or looked up again when a frame resumes after a nested
+        // child. The compact instantiation carries no indentation or newline logic.
+        template <bool Pretty>
+        void format_complex_node_(const json_value& value, const json_serialize_options& options,
+            json_writer& out) const {
+            std::size_t indent_level{ 0 };
+            std::stack<format_frame_t> stack;
+            member_order_t order{};
+
+            auto open = [&](format_frame_t& frame, char bracket, std::size_t size) {
+                frame.size = size;
+                out.put(bracket);
+                if constexpr (Pretty) {
+                    if (size != 0) {
+                        out.put('\n');
+                        ++indent_level;
                     }
-                    else {
-                        oss << "\n";
+                }
+            };
+
+            auto separate = [&](const format_frame_t& frame) {
+                if (frame.index != 0) {
+                    out.put(',');
+                    if constexpr (Pretty) {
+                        out.put('\n');
+                    }
+                }
+                if constexpr (Pretty) {
+                    out.fill(' ', indent_level * options.indent_size);
+                }
+            };
+
+            auto close = [&](const format_frame_t& frame, char bracket) {
+                if constexpr (Pretty) {
+                    if (frame.size != 0) {
+                        out.put('\n');
+                        --indent_level;
+                        out.fill(' ', indent_level * options.indent_size);
                     }
                 }
+                out.put(bracket);
+                stack.pop();
             };
 
+            stack.push({ &value });
+
             while (!stack.empty()) {
-                stack_frame& frame = stack.top();
+                format_frame_t& frame = stack.top();
+                bool next{ false };
                 if (frame.ptr->is<json_array>()) {
                     const json_array& arr = frame.ptr->as<json_array>();
-                    frame.size = arr.size();
-                    if (frame.size == 0) {
-                        oss << "[]";
-                        stack.pop();
-                        check_comma();
-                        continue;
-                    }
                     if (frame.index == 0) {
-                        oss << "[\n";
-                        indent_level++;
+                        open(frame, '[', arr.size());
                     }
-                    bool next{ false };
                     while (frame.index < frame.size) {
-                        oss << std::string(indent_level * indent_size, ' ');
-                        if (arr[frame.index].is<json_object>() || arr[frame.index].is<json_array>()) {
-                            stack.push({ &arr[frame.index] });
-                            ++frame.index;
+                        const json_value& item = arr[frame.index];
+                        separate(frame);
+                        ++frame.index;
+                        if (item.is<json_object>() || item.is<json_array>()) {
+                            stack.push({ &item });
                             next = true;
                             break;
                         }
-                        else {
-                            oss << format_simple_node_(arr[frame.index]);
-                        }
-                        if (frame.index < frame.size - 1) {
-                            oss << ",\n";
-                        }
-                        else {
-                            oss << "\n";
-                        }
-                        frame.index++;
+                        format_simple_node_(item, out);
                     }
                     if (!next) {
-                        --indent_level;
-                        oss << std::string(indent_level * indent_size, ' ') << "]";
-                        stack.pop();
-                        check_comma();
+                        close(frame, ']');
                     }
-
                 }
                 else { // frame.ptr->is<json_object>()
                     const json_object& obj = frame.ptr->as<json_object>();
-                    frame.size = obj.size();
-                    if (frame.size == 0) {
-                        oss << "{}";
-                        stack.pop();
-                        check_comma();
-                        continue;
-                    }
-                    else {
-                        for (const auto& [key, _] : obj) {
-                            frame.keys.push_back(key);
-                        }
-                    }
                     if (frame.index == 0) {
-                        oss << "{\n";
-                        indent_level++;
+                        open(frame, '{', obj.size());
+                        if (options.sort_keys) {
+                            frame.order = order.size();
+                            sort_members_(obj, order);
+                        }
                     }
-                    bool next = false;
                     while (frame.index < frame.size) {
-                        const std::string& key = frame.keys[frame.index];
-                        const json_value& val = obj.at(key);
-
-                        oss << std::string(indent_level * indent_size, ' ')
-                            << format_string_(key) << ": ";
-
+                        const auto& [key, val] = options.sort_keys ?
+                            *order[frame.order + frame.index] :
+                            obj.begin()[static_cast<std::ptrdiff_t>(frame.index)];
+                        separate(frame);
+                        ++frame.index;
+                        format_string_(key, out);
+                        if constexpr (Pretty) {
+                            out.write(": ");
+                        }
+                        else {
+                            out.put(':');
+                        }
                         if (val.is<json_object>() || val.is<json_array>()) {
                             stack.push({ &val });
-                            ++frame.index;
                             next = true;
                             break;
                         }
-                        else {
-                            oss << format_simple_node_(val);
-                        }
-
-                        if (frame.index < frame.size - 1) {
-                            oss << ",\n";
-                        }
-                        else {
-                            oss << "\n";
-                        }
-
-                        ++frame.index;
+                        format_simple_node_(val, out);
                     }
-
                     if (!next) {
-                        --indent_level;
-                        oss << std::string(indent_level * indent_size, ' ') << "}";
-                        stack.pop();
-                        check_comma();
+                        if (options.sort_keys) {
+                            order.resize(frame.order);
+                        }
+                        close(frame, '}');
                     }
                 }
             }
-
-            return oss.str();
         }
 
+        // Shortest digits that parse back to the same double. Integral values keep a ".0" so they
+        // read back as doubles; JSON has no spelling for NaN or infinity, so those become null.
+        static void format_double_(json_double_t value, json_writer& out) {
+            if (!std::isfinite(value)) {
+                out.write("null");
+                return;
+            }
+            char buffer[32];
+            char* end{ std::to_chars(buffer, buffer + sizeof(buffer) - 2, value).ptr };
+            if (std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+                *end++ = '.';
+                *end++ = '0';
+            }
+            out.write({ buffer, static_cast<std::size_t>(end - buffer) });
+        }
 
-        std::string format_simple_node_(const json_value& value) const {
+        void format_simple_node_(const json_value& value, json_writer& out) const {
             if (value.is<json_bool_t>()) {
-                return value.as<json_bool_t>() ? "true" : "false";
+                out.write(value.as<json_bool_t>() ? "true" : "false");
             }
             else if (value.is<json_int_t>()) {
-                return std::to_string(value.as<json_int_t>());
+                char buffer[24];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.as<json_int_t>());
+                out.write({ buffer, static_cast<std::size_t>(result.ptr - buffer) });
             }
             else if (value.is<json_double_t>()) {
-                std::ostringstream oss;
-                oss.precision(15);
-                oss << value.as<json_double_t>();
-                return oss.str();
+                format_double_(value.as<json_double_t>(), out);
             }
             else if (value.is<json_string_t>()) {
-                return format_string_(value.as<json_string_t>());
+                format_string_(value.as<json_string_t>(), out);
             }
             else { // json_null_t
-                return "null";
+                out.write("null");
             }
         }
 
@@ -985,7 +3368,8 @@ namespace json {
 
         json_value root_{};
         bool is_valid_{ true };
-        std::string error_message_{};
+        json_error error_{};
+        mutable std::string error_message_{};
 
     }; // class json_document
 
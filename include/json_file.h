@@ -0,0 +1,220 @@
+#pragma once
+
+// Memory-mapped file input for json.h. Kept out of json.h so that the platform headers, and
+// the macros they define, only reach translation units that read files.
+
+#include <json.h>
+#include <filesystem>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace json {
+
+    // Read-only mapping of a whole file; an empty file opens as an empty view. The lexer and the
+    // structural index never read past the end of their input, so the view needs no padding.
+    class json_mapped_file {
+    public:
+
+        json_mapped_file(const json_mapped_file&) = delete;
+        json_mapped_file& operator=(const json_mapped_file&) = delete;
+
+    public:
+
+        json_mapped_file() noexcept = default;
+
+        explicit json_mapped_file(const std::filesystem::path& path) {
+            map_(path);
+        }
+
+        json_mapped_file(json_mapped_file&& other) noexcept :
+            data_{ std::exchange(other.data_, nullptr) },
+            size_{ std::exchange(other.size_, 0) },
+            is_open_{ std::exchange(other.is_open_, false) }
+        {
+        }
+
+        json_mapped_file& operator=(json_mapped_file&& other) noexcept {
+            if (this != &other) {
+                unmap_();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                is_open_ = std::exchange(other.is_open_, false);
+            }
+            return *this;
+        }
+
+        ~json_mapped_file() {
+            unmap_();
+        }
+
+    public:
+
+        bool is_open() const noexcept {
+            return is_open_;
+        }
+
+        std::string_view view() const noexcept {
+            return { data_, size_ };
+        }
+
+    private:
+
+#if defined(_WIN32)
+        void map_(const std::filesystem::path& path) {
+            HANDLE file{ ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+            if (file == INVALID_HANDLE_VALUE) {
+                return;
+            }
+            LARGE_INTEGER size{};
+            if (::GetFileSizeEx(file, &size) && static_cast<std::uint64_t>(size.QuadPart) <= SIZE_MAX) {
+                if (size.QuadPart == 0) {
+                    is_open_ = true;
+                }
+                else if (HANDLE mapping{ ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) }) {
+                    data_ = static_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    ::CloseHandle(mapping);
+                    if (data_ != nullptr) {
+                        size_ = static_cast<std::size_t>(size.QuadPart);
+                        is_open_ = true;
+                    }
+                }
+            }
+            ::CloseHandle(file);
+        }
+
+        void unmap_() noexcept {
+            if (data_ != nullptr) {
+                ::UnmapViewOfFile(data_);
+            }
+            data_ = nullptr;
+            size_ = 0;
+            is_open_ = false;
+        }
+#else
+        void map_(const std::filesystem::path& path) {
+            int file{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+            if (file < 0) {
+                return;
+            }
+            struct stat info{};
+            if (::fstat(file, &info) == 0 && S_ISREG(info.st_mode) &&
+                static_cast<std::uintmax_t>(info.st_size) <= SIZE_MAX) {
+                std::size_t size{ static_cast<std::size_t>(info.st_size) };
+                if (size == 0) {
+                    is_open_ = true;
+                }
+                else if (void* data{ ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) }; data != MAP_FAILED) {
+                    data_ = static_cast<const char*>(data);
+                    size_ = size;
+                    is_open_ = true;
+                }
+            }
+            ::close(file);
+        }
+
+        void unmap_() noexcept {
+            if (data_ != nullptr) {
+                ::munmap(const_cast<char*>(data_), size_);
+            }
+            data_ = nullptr;
+            size_ = 0;
+            is_open_ = false;
+        }
+#endif
+
+    private:
+
+        const char* data_{ nullptr };
+        std::size_t size_{ 0 };
+        bool is_open_{ false };
+
+    }; // class json_mapped_file
+
+    namespace detail {
+        struct file_access {
+            static void fail(json_document& document) {
+                document.is_valid_ = false;
+                document.error_ = { json_errc::file_error, 0, '\0' };
+                document.error_message_.clear();
+            }
+        };
+
+    } // namespace detail
+
+    // Parses the file through a read-only mapping instead of a copy in a std::string. The tree
+    // owns its strings, so the mapping is released before returning; use json_ondemand_file to
+    // keep reading from the mapped file. A file that cannot be mapped reports file_error.
+    [[nodiscard]] inline json_document parse_file(const std::filesystem::path& path, const json_parse_options& options = {}) {
+        json_document document;
+        json_mapped_file file(path);
+        if (!file.is_open()) {
+            detail::file_access::fail(document);
+        }
+        else {
+            document.from_string(file.view(), options);
+        }
+        return document;
+    }
+
+    // On-demand document over a mapped file. It owns the mapping, so handles taken from root()
+    // stay valid as long as it lives, and raw_json() or get_string() of a string without
+    // escapes point into the file. Moving it does not move the mapping.
+    class json_ondemand_file {
+    public:
+
+        explicit json_ondemand_file(const std::filesystem::path& path, const json_parse_options& options = {}) :
+            file_{ path },
+            document_{ file_.view(), options }
+        {
+        }
+
+    public:
+
+        // The null value when the file could not be mapped or is not valid
+        [[nodiscard]] json_ondemand_value root() const noexcept {
+            return document_.root();
+        }
+
+        const json_ondemand_document& document() const noexcept {
+            return document_;
+        }
+
+        bool is_valid() const {
+            return file_.is_open() && document_.is_valid();
+        }
+
+        const json_error& error() const {
+            static const json_error file_error{ json_errc::file_error, 0, '\0' };
+            return file_.is_open() ? document_.error() : file_error;
+        }
+
+        const std::string& error_message() const {
+            if (!file_.is_open()) {
+                static const std::string message{ error_text(json_errc::file_error) };
+                return message;
+            }
+            return document_.error_message();
+        }
+
+    private:
+
+        json_mapped_file file_;
+        json_ondemand_document document_;
+
+    }; // class json_ondemand_file
+
+} // namespace json
@@ -0,0 +1,235 @@
+#pragma once
+
+// Parallel reader for newline-delimited JSON on top of json.h. Kept out of json.h so that only
+// translation units reading JSON Lines pull in the threading headers; link Threads::Threads.
+
+#include <json.h>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace json {
+
+    struct json_ndjson_options {
+        json_parse_options parse{};
+        // Worker threads, 0 for std::thread::hardware_concurrency(). With more than one,
+        // parse.memory_resource must be safe to use from several threads at once.
+        std::size_t threads{ 0 };
+        // Input bytes a worker splits and parses at a time, extended to the end of its last line
+        std::size_t batch_size{ 1 << 20 };
+    };
+
+    struct json_ndjson_record {
+        std::size_t index{ 0 };     // position among the non-blank lines of the input
+        std::size_t offset{ 0 };    // first byte of the line, document error offsets are relative to it
+        json_document document{};
+    };
+
+    // Newline-delimited JSON (JSON Lines): one document per line, blank lines skipped. The input
+    // is cut into batches of whole lines that the workers split and parse independently; a batch
+    // finds its own first line, so no thread scans the input ahead of the others. Records are
+    // still delivered in input order, and at most two batches per worker are held at once.
+    class json_ndjson_reader {
+    public:
+
+        json_ndjson_reader() = delete;
+        json_ndjson_reader(const json_ndjson_reader&) = delete;
+        json_ndjson_reader(json_ndjson_reader&&) = delete;
+        json_ndjson_reader& operator=(const json_ndjson_reader&) = delete;
+        json_ndjson_reader& operator=(json_ndjson_reader&&) = delete;
+
+    public:
+
+        // source must outlive the reader
+        explicit json_ndjson_reader(std::string_view source, const json_ndjson_options& options = {}) :
+            source_{ source },
+            options_{ options }
+        {
+            if (options_.batch_size == 0) {
+                options_.batch_size = 1;
+            }
+            if (options_.threads == 0) {
+                options_.threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+            }
+        }
+
+    public:
+
+        // Calls callback(json_ndjson_record&&) on the calling thread for every line in input
+        // order, while the workers parse the batches ahead of it. An exception thrown by a worker
+        // or by callback stops the workers and propagates from here.
+        template <typename Callback>
+        void for_each(Callback&& callback) {
+            std::size_t batches{ source_.empty() ? 0 : (source_.size() - 1) / options_.batch_size + 1 };
+            std::size_t index{ 0 };
+            auto deliver = [&](std::vector<json_ndjson_record>& records) {
+                for (json_ndjson_record& record : records) {
+                    record.index = index++;
+                    callback(std::move(record));
+                }
+            };
+
+            std::size_t threads{ std::min(options_.threads, batches) };
+            if (threads <= 1) {
+                std::vector<json_ndjson_record> records;
+                for (std::size_t batch = 0; batch < batches; ++batch) {
+                    records.clear();
+                    parse_batch_(batch, records);
+                    deliver(records);
+                }
+                return;
+            }
+
+            shared_t shared(2 * threads);
+            workers_t workers{ shared, {} };
+            workers.threads.reserve(threads);
+            for (std::size_t i = 0; i < threads; ++i) {
+                workers.threads.emplace_back([this, &shared, batches] { work_(shared, batches); });
+            }
+
+            std::vector<json_ndjson_record> records;
+            for (std::size_t batch = 0; batch < batches; ++batch) {
+                slot_t& slot{ shared.slots[batch % shared.slots.size()] };
+                {
+                    std::unique_lock lock(shared.mutex);
+                    shared.changed.wait(lock, [&] { return slot.ready || shared.stop; });
+                    if (!slot.ready) {
+                        std::rethrow_exception(shared.error);
+                    }
+                    records.swap(slot.records);
+                    slot.ready = false;
+                    shared.delivered = batch + 1;
+                }
+                shared.changed.notify_all();
+                deliver(records);
+                records.clear();
+            }
+        }
+
+        // Every line of the input, in order
+        [[nodiscard]] std::vector<json_ndjson_record> parse() {
+            std::vector<json_ndjson_record> records;
+            for_each([&records](json_ndjson_record&& record) { records.push_back(std::move(record)); });
+            return records;
+        }
+
+    private:
+
+        struct slot_t {
+            std::vector<json_ndjson_record> records{};
+            bool ready{ false };
+        };
+
+        // Batch b is parsed into slots[b % slots.size()] once every batch before b - slots.size()
+        // has been delivered, which bounds the memory held ahead of the callback
+        struct shared_t {
+            explicit shared_t(std::size_t window) :
+                slots(window)
+            {
+            }
+
+            std::mutex mutex{};
+            std::condition_variable changed{};
+            std::vector<slot_t> slots;
+            std::size_t next_batch{ 0 };
+            std::size_t delivered{ 0 };
+            bool stop{ false };
+            std::exception_ptr error{};
+        };
+
+        // Stops and joins the workers on every exit from for_each
+        struct workers_t {
+            ~workers_t() {
+                {
+                    std::lock_guard lock(shared.mutex);
+                    shared.stop = true;
+                }
+                shared.changed.notify_all();
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+            }
+
+            shared_t& shared;
+            std::vector<std::thread> threads;
+        };
+
+        void work_(shared_t& shared, std::size_t batches) {
+            std::vector<json_ndjson_record> records;
+            while (true) {
+                std::size_t batch;
+                {
+                    std::unique_lock lock(shared.mutex);
+                    shared.changed.wait(lock, [&] {
+                        return shared.stop || shared.next_batch >= batches ||
+                            shared.next_batch < shared.delivered + shared.slots.size();
+                    });
+                    if (shared.stop || shared.next_batch >= batches) {
+                        return;
+                    }
+                    batch = shared.next_batch++;
+                }
+                try {
+                    parse_batch_(batch, records);
+                }
+                catch (...) {
+                    std::lock_guard lock(shared.mutex);
+                    shared.error = std::current_exception();
+                    shared.stop = true;
+                    shared.changed.notify_all();
+                    return;
+                }
+                {
+                    std::lock_guard lock(shared.mutex);
+                    slot_t& slot{ shared.slots[batch % shared.slots.size()] };
+                    slot.records.swap(records);
+                    slot.ready = true;
+                }
+                shared.changed.notify_all();
+                records.clear();
+            }
+        }
+
+        // First line starting at or after pos
+        std::size_t line_start_(std::size_t pos) const noexcept {
+            if (pos == 0) {
+                return 0;
+            }
+            if (pos >= source_.size()) {
+                return source_.size();
+            }
+            const void* newline{ std::memchr(source_.data() + pos - 1, '\n', source_.size() - pos + 1) };
+            return newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - source_.data()) + 1 : source_.size();
+        }
+
+        // batch * batch_size clamped to the source size, without overflowing
+        std::size_t batch_bound_(std::size_t batch) const noexcept {
+            return batch > source_.size() / options_.batch_size ? source_.size() : batch * options_.batch_size;
+        }
+
+        // Parses the lines starting in [batch * batch_size, (batch + 1) * batch_size)
+        void parse_batch_(std::size_t batch, std::vector<json_ndjson_record>& records) const {
+            std::size_t pos{ line_start_(batch_bound_(batch)) };
+            std::size_t end{ line_start_(batch_bound_(batch + 1)) };
+            while (pos < end) {
+                const void* newline{ std::memchr(source_.data() + pos, '\n', end - pos) };
+                std::size_t line_end{ newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - source_.data()) : end };
+                std::string_view line{ source_.substr(pos, line_end - pos) };
+                if (detail::skip_whitespace_from(line, 0) != line.size()) {
+                    json_ndjson_record& record{ records.emplace_back() };
+                    record.offset = pos;
+                    record.document.from_string(line, options_.parse);
+                }
+                pos = line_end + 1;
+            }
+        }
+
+    private:
+
+        std::string_view source_;
+        json_ndjson_options options_;
+
+    }; // class json_ndjson_reader
+
+} // namespace json